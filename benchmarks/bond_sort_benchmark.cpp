@@ -0,0 +1,94 @@
+// Times GrainSegmentationEngine1::radixSortByDisorientation against a comparison sort on
+// (disorientation, a, b), the order the radix sort reproduces for bonds in table order.
+//
+//   bond_sort_benchmark [bonds = 30000000] [repetitions = 5]
+#include <volt/grain_segmentation_engine.h>
+#include <tbb/parallel_sort.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace Volt;
+
+using Engine = GrainSegmentationEngine1<uint32_t, double>;
+using PackedBond = Engine::PackedBond;
+
+namespace{
+
+// Bonds in table order: increasing a, each atom owning up to 6 bonds to higher atoms,
+// with disorientations below the 4 degree threshold, quantized so that ties occur.
+std::vector<PackedBond> makeBonds(size_t count){
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<float> angle(0.0f, 4.0f);
+    std::uniform_int_distribution<uint32_t> offset(1, 64);
+
+    std::vector<PackedBond> bonds(count);
+    uint32_t a = 0;
+    for(size_t i = 0; i < count; i++){
+        if(i % 6 == 0) a++;
+        const float disorientation = std::round(angle(rng) * 4096.0f) / 4096.0f;
+        bonds[i] = { disorientation, a, a + offset(rng) };
+    }
+    for(size_t i = 0; i < count; i += 6){
+        std::sort(bonds.begin() + i, bonds.begin() + std::min(count, i + 6), [](const PackedBond& x, const PackedBond& y){
+            return x.b < y.b;
+        });
+    }
+    return bonds;
+}
+
+bool sameOrder(const std::vector<PackedBond>& x, const std::vector<PackedBond>& y){
+    return std::equal(x.begin(), x.end(), y.begin(), [](const PackedBond& u, const PackedBond& v){
+        return u.disorientation == v.disorientation && u.a == v.a && u.b == v.b;
+    });
+}
+
+template<typename Sort>
+double bestSeconds(const std::vector<PackedBond>& input, int repetitions, std::vector<PackedBond>& output, Sort sort){
+    double best = 1e300;
+    for(int r = 0; r < repetitions; r++){
+        output = input;
+        const auto start = std::chrono::steady_clock::now();
+        sort(output);
+        const auto stop = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(stop - start).count());
+    }
+    return best;
+}
+
+}
+
+int main(int argc, char* argv[]){
+    const size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 30000000;
+    const int repetitions = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    const std::vector<PackedBond> input = makeBonds(count);
+    std::vector<PackedBond> radix;
+    std::vector<PackedBond> reference;
+
+    const double radixSeconds = bestSeconds(input, repetitions, radix, [](std::vector<PackedBond>& bonds){
+        Engine::radixSortByDisorientation(bonds);
+    });
+    const double referenceSeconds = bestSeconds(input, repetitions, reference, [](std::vector<PackedBond>& bonds){
+        tbb::parallel_sort(bonds.begin(), bonds.end(), [](const PackedBond& x, const PackedBond& y){
+            if(x.disorientation != y.disorientation) return x.disorientation < y.disorientation;
+            if(x.a != y.a) return x.a < y.a;
+            return x.b < y.b;
+        });
+    });
+
+    std::printf("bonds: %zu, best of %d\n", count, repetitions);
+    std::printf("radix sort:          %8.3f s\n", radixSeconds);
+    std::printf("tbb::parallel_sort:  %8.3f s\n", referenceSeconds);
+    std::printf("speedup:             %8.2fx\n", referenceSeconds / radixSeconds);
+
+    if(!sameOrder(radix, reference)){
+        std::fprintf(stderr, "radix sort order differs from (disorientation, a, b)\n");
+        return 1;
+    }
+    return 0;
+}
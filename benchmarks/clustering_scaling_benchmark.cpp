@@ -0,0 +1,89 @@
+// Times GrainSegmentationEngine1 on a synthetic polycrystal with the nearest-neighbor
+// chain and with round-based reciprocal clustering at 1, 2, 4, ... threads up to the
+// hardware concurrency, and checks that every thread count gives the dendrogram of the
+// single-threaded run of the same mode.
+//
+//   clustering_scaling_benchmark [cells per side = 48] [grains = 40] [repetitions = 3]
+#include "synthetic_polycrystal.h"
+
+#include <oneapi/tbb/global_control.h>
+#include <tbb/info.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace Volt;
+using namespace Volt::Testing;
+
+using Engine = GrainSegmentationEngine1<uint32_t, double>;
+
+namespace{
+
+double runEngine(const SyntheticPolycrystal& crystal, const std::shared_ptr<ParticleProperty>& orientations, ClusteringMode mode, std::vector<Engine::DendrogramNode>& dendrogram){
+    const auto start = std::chrono::steady_clock::now();
+    Engine engine(crystal.positions, crystal.structures, orientations, crystal.correspondences, &crystal.cell, true, false);
+    engine.setClusteringMode(mode);
+    engine.perform();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    dendrogram = engine.dendrogram();
+    return seconds;
+}
+
+bool sameDendrogram(const std::vector<Engine::DendrogramNode>& x, const std::vector<Engine::DendrogramNode>& y){
+    return x.size() == y.size() && std::equal(x.begin(), x.end(), y.begin(), [](const Engine::DendrogramNode& p, const Engine::DendrogramNode& q){
+        return p.a == q.a && p.b == q.b && p.distance == q.distance;
+    });
+}
+
+}
+
+int main(int argc, char* argv[]){
+    const int cellsPerSide = argc > 1 ? std::atoi(argv[1]) : 48;
+    const int grains = argc > 2 ? std::atoi(argv[2]) : 40;
+    const int repetitions = argc > 3 ? std::atoi(argv[3]) : 3;
+
+    const SyntheticPolycrystal crystal = makeSyntheticPolycrystal(cellsPerSide, grains, 7);
+    const std::shared_ptr<ParticleProperty> orientations = crystal.orientationProperty(DataType::Double);
+    const int maxThreads = tbb::info::default_concurrency();
+
+    std::printf("atoms: %zu, grains: %d, best of %d\n", crystal.size(), grains, repetitions);
+    std::printf("%8s %12s %12s %10s\n", "threads", "chain [s]", "rac [s]", "rac speedup");
+
+    int failures = 0;
+    double reciprocalSerial = 0.0;
+    std::vector<Engine::DendrogramNode> chainReference;
+    std::vector<Engine::DendrogramNode> reciprocalReference;
+    std::vector<int> threadCounts;
+    for(int threads = 1; threads < maxThreads; threads *= 2){
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    for(const int threads : threadCounts){
+        oneapi::tbb::global_control parallelControl(oneapi::tbb::global_control::max_allowed_parallelism, threads);
+
+        double chainBest = 1e300;
+        double reciprocalBest = 1e300;
+        std::vector<Engine::DendrogramNode> dendrogram;
+        for(int r = 0; r < repetitions; r++){
+            chainBest = std::min(chainBest, runEngine(crystal, orientations, ClusteringMode::Chain, dendrogram));
+            if(threads == 1 && r == 0) chainReference = dendrogram;
+            else if(!sameDendrogram(dendrogram, chainReference)) failures++;
+
+            reciprocalBest = std::min(reciprocalBest, runEngine(crystal, orientations, ClusteringMode::Reciprocal, dendrogram));
+            if(threads == 1 && r == 0) reciprocalReference = dendrogram;
+            else if(!sameDendrogram(dendrogram, reciprocalReference)) failures++;
+        }
+        if(threads == 1) reciprocalSerial = reciprocalBest;
+        std::printf("%8d %12.3f %12.3f %9.2fx\n", threads, chainBest, reciprocalBest, reciprocalSerial / reciprocalBest);
+    }
+
+    if(failures){
+        std::fprintf(stderr, "%d runs produced a dendrogram different from the single-threaded run\n", failures);
+        return 1;
+    }
+    return 0;
+}
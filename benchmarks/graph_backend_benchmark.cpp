@@ -0,0 +1,150 @@
+// Times the nearest-neighbor chain on GrainSegmentationEngine1's TreeGraph and FlatGraph
+// backends for a periodic grid graph with bond-graph-like weights, and checks that both
+// produce the same merge sequence.
+//
+//   graph_backend_benchmark [nodes per side = 64] [neighbors per node = 12] [repetitions = 3]
+#include <volt/grain_segmentation_engine.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <tuple>
+#include <vector>
+
+using namespace Volt;
+
+using Engine = GrainSegmentationEngine1<uint32_t, double>;
+
+namespace{
+
+struct Edge{
+    uint32_t u;
+    uint32_t v;
+    double weight;
+};
+
+struct Merge{
+    uint32_t a;
+    uint32_t b;
+    double distance;
+};
+
+// Each node links to its first neighborsPerNode / 2 forward neighbors on a periodic cubic
+// grid (face, then edge diagonals), so every node ends up with neighborsPerNode edges.
+// Weights are the engine's exp(-theta^2 / 3) for disorientations up to the 4 degree
+// threshold.
+std::vector<Edge> makeEdges(int side, int neighborsPerNode){
+    const int offsets[6][3] = {
+        { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 }, { 1, 1, 0 }, { 1, 0, 1 }, { 0, 1, 1 }
+    };
+    const int forward = std::clamp(neighborsPerNode / 2, 1, 6);
+
+    std::mt19937 rng(99);
+    std::uniform_real_distribution<double> angle(0.0, 4.0);
+    auto node = [side](int x, int y, int z){
+        return (uint32_t) ((((z + side) % side) * side + (y + side) % side) * side + (x + side) % side);
+    };
+
+    std::vector<Edge> edges;
+    edges.reserve((size_t) side * side * side * forward);
+    for(int z = 0; z < side; z++){
+        for(int y = 0; y < side; y++){
+            for(int x = 0; x < side; x++){
+                for(int k = 0; k < forward; k++){
+                    const double theta = angle(rng);
+                    edges.push_back({ node(x, y, z), node(x + offsets[k][0], y + offsets[k][1], z + offsets[k][2]), std::exp(-theta * theta / 3.0) });
+                }
+            }
+        }
+    }
+    return edges;
+}
+
+// The merge loop of node_pair_sampling_clustering without the orientation bookkeeping.
+template<typename Graph>
+std::vector<Merge> runChain(size_t numNodes, const std::vector<Edge>& edges, double& seconds){
+    const auto start = std::chrono::steady_clock::now();
+    Graph graph(numNodes, edges.size());
+    for(const Edge& edge : edges){
+        graph.add_edge(edge.u, edge.v, edge.weight);
+    }
+
+    std::vector<Merge> merges;
+    merges.reserve(numNodes);
+    std::vector<uint32_t> chain;
+    while(graph.num_nodes()){
+        chain.push_back(graph.next_node());
+        while(!chain.empty()){
+            const uint32_t a = chain.back();
+            chain.pop_back();
+
+            const auto [d, b] = graph.nearestNeighbor(a);
+            if(b == Engine::InvalidIndex){
+                graph.remove_node(a);
+            }else if(!chain.empty()){
+                const uint32_t c = chain.back();
+                chain.pop_back();
+                if(b == c){
+                    const uint32_t parent = graph.contract_edge(a, b);
+                    merges.push_back({ parent, parent == a ? b : a, d });
+                }else{
+                    chain.push_back(c);
+                    chain.push_back(a);
+                    chain.push_back(b);
+                }
+            }else{
+                chain.push_back(a);
+                chain.push_back(b);
+            }
+        }
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return merges;
+}
+
+template<typename Graph>
+double bestSeconds(size_t numNodes, const std::vector<Edge>& edges, int repetitions, std::vector<Merge>& merges){
+    double best = 1e300;
+    for(int r = 0; r < repetitions; r++){
+        double seconds = 0.0;
+        merges = runChain<Graph>(numNodes, edges, seconds);
+        best = std::min(best, seconds);
+    }
+    return best;
+}
+
+bool sameMerges(const std::vector<Merge>& x, const std::vector<Merge>& y){
+    return x.size() == y.size() && std::equal(x.begin(), x.end(), y.begin(), [](const Merge& p, const Merge& q){
+        return p.a == q.a && p.b == q.b && p.distance == q.distance;
+    });
+}
+
+}
+
+int main(int argc, char* argv[]){
+    const int side = argc > 1 ? std::atoi(argv[1]) : 64;
+    const int neighborsPerNode = argc > 2 ? std::atoi(argv[2]) : 12;
+    const int repetitions = argc > 3 ? std::atoi(argv[3]) : 3;
+
+    const size_t numNodes = (size_t) side * side * side;
+    const std::vector<Edge> edges = makeEdges(side, neighborsPerNode);
+
+    std::vector<Merge> treeMerges;
+    std::vector<Merge> flatMerges;
+    const double treeSeconds = bestSeconds<Engine::TreeGraph>(numNodes, edges, repetitions, treeMerges);
+    const double flatSeconds = bestSeconds<Engine::FlatGraph>(numNodes, edges, repetitions, flatMerges);
+
+    std::printf("nodes: %zu, edges: %zu, merges: %zu, best of %d\n", numNodes, edges.size(), treeMerges.size(), repetitions);
+    std::printf("TreeGraph:  %8.3f s\n", treeSeconds);
+    std::printf("FlatGraph:  %8.3f s\n", flatSeconds);
+    std::printf("speedup:    %8.2fx\n", treeSeconds / flatSeconds);
+
+    if(!sameMerges(treeMerges, flatMerges)){
+        std::fprintf(stderr, "FlatGraph merge sequence differs from TreeGraph\n");
+        return 1;
+    }
+    return 0;
+}
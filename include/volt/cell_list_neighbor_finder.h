@@ -0,0 +1,208 @@
+#pragma once
+
+#include <volt/core/particle_property.h>
+#include <volt/core/simulation_cell.h>
+#include <volt/cpu_kernels.h>
+
+#include <vector>
+#include <array>
+#include <span>
+#include <cmath>
+#include <algorithm>
+
+namespace Volt{
+
+// Binned k-nearest-neighbor search for dense, near-uniform frames. Atoms are sorted into
+// bins that are about as wide as the k-th neighbor distance, and a query scans rings of
+// bins around the atom until no unseen atom can be closer than the k-th neighbor found.
+class CellListNeighborFinder{
+public:
+    struct Neighbor{
+        size_t index;
+        double distanceSq;
+    };
+
+    // Returns false if the cell is degenerate.
+    bool prepare(const Point3* positions, size_t count, const SimulationCell& cell, int neighborsPerAtom);
+
+    bool isOrthogonal() const{
+        return _orthogonal;
+    }
+
+    template<int MAX_NEIGHBORS>
+    class Query{
+    public:
+        explicit Query(const CellListNeighborFinder& finder) : _finder(finder){}
+
+        void findNeighbors(size_t index){
+            if(_finder._orthogonal){
+                findNeighborsImpl<true>(index);
+            }else{
+                findNeighborsImpl<false>(index);
+            }
+        }
+
+        // Neighbors ordered by increasing distance.
+        std::span<const Neighbor> results() const{
+            return std::span<const Neighbor>(_results.data(), _count);
+        }
+
+    private:
+        template<bool Orthogonal>
+        void findNeighborsImpl(size_t index){
+            const CellListNeighborFinder& f = _finder;
+            const Point3& center = f._wrappedPositions[index];
+            const size_t bin = f._atomBins[index];
+            const int home[3] = {
+                int(bin % f._bins[0]),
+                int((bin / f._bins[0]) % f._bins[1]),
+                int(bin / (size_t(f._bins[0]) * f._bins[1]))
+            };
+
+            _count = 0;
+            for(int ring = 0; ring <= f._maxRing; ++ring){
+                // Rows on the faces of the ring shell are scanned whole; inner rows only
+                // contribute their two end bins.
+                for(int dz = -ring; dz <= ring; ++dz){
+                    for(int dy = -ring; dy <= ring; ++dy){
+                        if(std::abs(dy) == ring || std::abs(dz) == ring){
+                            visitRow<Orthogonal>(index, center, home, -ring, ring, dy, dz);
+                        }else{
+                            visitRow<Orthogonal>(index, center, home, -ring, -ring, dy, dz);
+                            visitRow<Orthogonal>(index, center, home, ring, ring, dy, dz);
+                        }
+                    }
+                }
+
+                // Every atom closer than ring * minBinWidth has been visited.
+                const double covered = ring * f._minBinWidth;
+                if(_count == MAX_NEIGHBORS && _results[_count - 1].distanceSq <= covered * covered){
+                    break;
+                }
+            }
+        }
+
+        // Maps a bin coordinate to the primary cell and the periodic image it came from.
+        // Returns false if it lies outside a non-periodic dimension.
+        bool wrapBin(int dim, int c, int& cell, int& image) const{
+            const CellListNeighborFinder& f = _finder;
+            if(!f._pbc[dim]){
+                if(c < 0 || c >= f._bins[dim]) return false;
+                cell = c;
+                image = 0;
+                return true;
+            }
+            image = (c >= 0) ? c / f._bins[dim] : -((-c + f._bins[dim] - 1) / f._bins[dim]);
+            cell = c - image * f._bins[dim];
+            return true;
+        }
+
+        // Visits the bins home + (dxBegin..dxEnd, dy, dz). Bins of one row that share a
+        // periodic image are contiguous in the sorted atom arrays.
+        template<bool Orthogonal>
+        void visitRow(size_t index, const Point3& center, const int home[3], int dxBegin, int dxEnd, int dy, int dz){
+            const CellListNeighborFinder& f = _finder;
+            int image[3];
+            int cy, cz;
+            if(!wrapBin(1, home[1] + dy, cy, image[1])) return;
+            if(!wrapBin(2, home[2] + dz, cz, image[2])) return;
+
+            int x = home[0] + dxBegin;
+            int xEnd = home[0] + dxEnd;
+            if(!f._pbc[0]){
+                x = std::max(x, 0);
+                xEnd = std::min(xEnd, f._bins[0] - 1);
+            }
+
+            while(x <= xEnd){
+                int cx;
+                wrapBin(0, x, cx, image[0]);
+                const int runEnd = std::min(xEnd, x + (f._bins[0] - 1 - cx));
+                visitRun<Orthogonal>(index, center, cx, cx + (runEnd - x), cy, cz, image);
+                x = runEnd + 1;
+            }
+        }
+
+        template<bool Orthogonal>
+        void visitRun(size_t index, const Point3& center, int cxBegin, int cxEnd, int cy, int cz, const int image[3]){
+            const CellListNeighborFinder& f = _finder;
+            const size_t row = size_t(f._bins[0]) * (cy + size_t(f._bins[1]) * cz);
+            const size_t begin = f._binOffsets[row + cxBegin];
+            const size_t end = f._binOffsets[row + cxEnd + 1];
+            if(begin == end) return;
+
+            Vector3 shift;
+            if constexpr(Orthogonal){
+                shift = Vector3(image[0] * f._boxLengths[0], image[1] * f._boxLengths[1], image[2] * f._boxLengths[2]);
+            }else{
+                shift = Vector3(0, 0, 0);
+                for(int dim = 0; dim < 3; ++dim){
+                    for(int k = 0; k < 3; ++k){
+                        shift[k] += image[dim] * f._cellVectors[dim][k];
+                    }
+                }
+            }
+            const bool selfImage = (image[0] == 0 && image[1] == 0 && image[2] == 0);
+
+            // Distances to the shifted atoms equal distances from the unshifted center.
+            const size_t count = end - begin;
+            if(_distancesSq.size() < count) _distancesSq.resize(count);
+            computeSquaredDistances(&f._binX[begin], &f._binY[begin], &f._binZ[begin], count,
+                center.x() - shift.x(), center.y() - shift.y(), center.z() - shift.z(), _distancesSq.data());
+
+            for(size_t k = 0; k < count; ++k){
+                const size_t j = f._binAtoms[begin + k];
+                if(j == index && selfImage) continue;
+                insert(j, _distancesSq[k]);
+            }
+        }
+
+        // Keeps the MAX_NEIGHBORS closest candidates sorted by (distance, index).
+        void insert(size_t index, double distanceSq){
+            auto closer = [](double d1, size_t i1, double d2, size_t i2){
+                return d1 < d2 || (d1 == d2 && i1 < i2);
+            };
+
+            if(_count == MAX_NEIGHBORS){
+                const Neighbor& last = _results[_count - 1];
+                if(!closer(distanceSq, index, last.distanceSq, last.index)) return;
+                --_count;
+            }
+
+            int pos = _count;
+            while(pos > 0 && closer(distanceSq, index, _results[pos - 1].distanceSq, _results[pos - 1].index)){
+                _results[pos] = _results[pos - 1];
+                --pos;
+            }
+            _results[pos] = { index, distanceSq };
+            ++_count;
+        }
+
+        const CellListNeighborFinder& _finder;
+        std::array<Neighbor, MAX_NEIGHBORS> _results;
+        std::vector<double> _distancesSq;
+        int _count = 0;
+    };
+
+private:
+    bool _orthogonal = false;
+    bool _pbc[3] = { false, false, false };
+    int _bins[3] = { 1, 1, 1 };
+    int _maxRing = 0;
+    double _minBinWidth = 0.0;
+    double _boxLengths[3] = { 0.0, 0.0, 0.0 };
+    Vector3 _cellVectors[3];
+
+    // Atoms sorted by bin, with their positions wrapped into the primary cell and
+    // stored per coordinate for the distance kernel.
+    std::vector<size_t> _binOffsets;
+    std::vector<size_t> _binAtoms;
+    std::vector<double> _binX;
+    std::vector<double> _binY;
+    std::vector<double> _binZ;
+
+    std::vector<size_t> _atomBins;
+    std::vector<Point3> _wrappedPositions;
+};
+
+}
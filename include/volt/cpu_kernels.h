@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+
+// Kernels are compiled for every x86 ISA level with target attributes and picked at
+// run time, so one binary runs on any node of a heterogeneous cluster.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define VOLT_X86_KERNELS 1
+#endif
+
+namespace Volt{
+
+enum class KernelIsa{
+    Scalar,
+    Avx2,
+    Avx512
+};
+
+// Best instruction set supported by the running CPU, detected once on first use.
+KernelIsa kernelIsa();
+
+// "scalar", "avx2" or "avx512".
+const char* kernelIsaName(KernelIsa isa);
+
+// Whether the running CPU can execute the kernels of the given instruction set.
+bool kernelIsaSupported(KernelIsa isa);
+
+// out[i] = exp(-theta^2 / 3) with theta = disorientations[i] in degrees; angles below
+// 1e-5 count as zero. Every variant gives bit-identical results.
+void computeGraphWeights(const float* disorientations, size_t count, double* out);
+
+// computeGraphWeights with the variant of the given instruction set instead of the one
+// picked at run time, for tests and benchmarks. Falls back to scalar when the CPU does
+// not support it.
+void computeGraphWeights(KernelIsa isa, const float* disorientations, size_t count, double* out);
+
+// out[i] = squared distance between (x[i], y[i], z[i]) and (cx, cy, cz).
+void computeSquaredDistances(const double* x, const double* y, const double* z, size_t count, double cx, double cy, double cz, double* out);
+
+}
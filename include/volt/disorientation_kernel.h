@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Volt{
+
+// Point-group families handled by the batched disorientation kernel.
+enum class CrystalSymmetry{
+    Cubic,      // 24 proper rotations of the cube (SC, FCC, BCC).
+    Hexagonal   // 12 proper rotations of the conventional hexagonal cell (HCP).
+};
+
+// Orientation quaternions of a batch in structure-of-arrays form.
+struct QuaternionBatch{
+    const double* x;
+    const double* y;
+    const double* z;
+    const double* w;
+};
+
+// Writes the disorientation angle in degrees between a[i] and b[i] for i < count,
+// minimized over the rotations of the given symmetry, the same quantity that
+// PTM::calculateDisorientation returns for one pair of that symmetry. Runs the
+// variant chosen by kernelIsa(). Pairs whose identity misorientation is already below
+// half the smallest symmetry rotation skip the operator search, which makes inputs
+// reduced by reduceToFundamentalZone much cheaper. Instantiated for both symmetries.
+template<CrystalSymmetry Symmetry>
+void computeDisorientations(const QuaternionBatch& a, const QuaternionBatch& b, size_t count, float* out);
+
+// Fundamental-zone orientation with int16 components in units of 1 / 32767, a quarter of
+// the size of a double quaternion.
+struct QuantizedQuaternion{
+    int16_t x;
+    int16_t y;
+    int16_t z;
+    int16_t w;
+};
+
+// Quantizes a unit quaternion q = (x, y, z, w).
+QuantizedQuaternion quantizeOrientation(const double q[4]);
+
+// Approximate computeDisorientations for quantized fundamental-zone orientations: the
+// angle of the identity misorientation, read from a lookup table instead of acos, to
+// within about 0.01 degrees. Pairs outside the identity region, where another symmetry
+// rotation may give a smaller angle, get -1 and have to be evaluated exactly.
+template<CrystalSymmetry Symmetry>
+void approximateDisorientations(const QuantizedQuaternion* a, const QuantizedQuaternion* b, size_t count, float* out);
+
+// Rotates q = (x, y, z, w) in place into the fundamental zone of the symmetry, i.e. onto
+// the symmetrically equivalent orientation with the smallest rotation angle. Pairwise
+// disorientations are unchanged.
+void reduceToFundamentalZone(CrystalSymmetry symmetry, double q[4]);
+
+}
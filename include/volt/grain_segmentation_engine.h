@@ -7,6 +7,9 @@
 #include <volt/structures/crystal_structure_types.h>
 #include <volt/analysis/ptm.h>
 #include <volt/analysis/nearest_neighbor_finder.h>
+#include <volt/cell_list_neighbor_finder.h>
+#include <volt/disorientation_kernel.h>
+#include <volt/cpu_kernels.h>
 
 #include <ptm_functions.h>
 #include <boost/sort/sort.hpp>
@@ -17,30 +20,143 @@
 #include <tbb/enumerable_thread_specific.h>
 #include <tbb/partitioner.h>
 #include <tbb/parallel_sort.h>
+#include <tbb/parallel_scan.h>
 
 #include <vector>
-#include <unordered_set>
+#include <array>
+#include <optional>
 #include <queue>
 #include <cmath>
 #include <numeric>
 #include <limits>
 #include <stdexcept>
 #include <algorithm>
+#include <functional>
+#include <cstdint>
+#include <type_traits>
+#include <bit>
+#include <atomic>
+#include <tuple>
 
 namespace Volt{
 
+// How GrainSegmentationEngine1 obtains its per-atom neighbor lists.
+enum class NeighborSearchBackend{
+    PTM,        // Lists found by the PTM stage and passed to the engine.
+    Tree,       // NearestNeighborFinder tree search.
+    CellList    // CellListNeighborFinder binned search.
+};
+
+// What GrainSegmentationEngine1 did with the coherent-interface (FCC/HCP, cubic/hex
+// diamond) rotation pass.
+enum class InterfacePass{
+    Disabled,   // Coherent interfaces are not handled.
+    Skipped,    // No mixed cubic/hex phase pair exists in the frame.
+    Performed
+};
+
+// Order in which the coherent-interface pass rotates defect atoms.
+enum class InterfacePropagation{
+    Serial,     // One bond at a time in strict disorientation order.
+    Parallel    // All bonds of a disorientation band per round.
+};
+
+// Storage precision of the per-atom orientations in the engines.
+enum class OrientationPrecision{
+    Double,
+    Single      // float32; PTM orientations are only accurate to a fraction of a degree.
+};
+
+inline const char* orientationPrecisionName(OrientationPrecision precision){
+    switch(precision){
+        case OrientationPrecision::Double: return "double";
+        case OrientationPrecision::Single: return "single";
+    }
+    return "unknown";
+}
+
+// How GrainSegmentationEngine1 evaluates same-type cubic and hexagonal bonds.
+enum class DisorientationMode{
+    Exact,          // Batched kernel on double fundamental-zone orientations.
+    Approximate     // Lookup table on quantized orientations, exact near the threshold.
+};
+
+inline const char* disorientationModeName(DisorientationMode mode){
+    switch(mode){
+        case DisorientationMode::Exact: return "exact";
+        case DisorientationMode::Approximate: return "approximate";
+    }
+    return "unknown";
+}
+
+// Algorithm GrainSegmentationEngine1 uses to build the merge sequence.
+enum class ClusteringMode{
+    Chain,      // Nearest-neighbor chain per connected component.
+    Reciprocal  // Parallel rounds of reciprocal nearest-neighbor merges.
+};
+
+inline const char* clusteringModeName(ClusteringMode mode){
+    switch(mode){
+        case ClusteringMode::Chain: return "chain";
+        case ClusteringMode::Reciprocal: return "rac";
+    }
+    return "unknown";
+}
+
+inline const char* interfacePassName(InterfacePass pass){
+    switch(pass){
+        case InterfacePass::Disabled: return "disabled";
+        case InterfacePass::Skipped: return "skipped";
+        case InterfacePass::Performed: return "performed";
+    }
+    return "unknown";
+}
+
+// Orientation stored with the components in Real (float or double). All arithmetic
+// goes through Quaternion in double precision; only the storage is narrowed.
+template<typename Real>
+struct PackedQuaternion{
+    static_assert(std::is_floating_point_v<Real>, "PackedQuaternion needs a floating-point type");
+
+    Real x = 0;
+    Real y = 0;
+    Real z = 0;
+    Real w = 1;
+
+    PackedQuaternion() = default;
+    PackedQuaternion(const Quaternion& q) : x((Real) q.x()), y((Real) q.y()), z((Real) q.z()), w((Real) q.w()){}
+
+    Quaternion quaternion() const{
+        return Quaternion(x, y, z, w);
+    }
+};
+
+// Orientation i of a four-component orientation property. The service stores the
+// property as Float in single-precision mode and as Double otherwise.
+inline Quaternion propertyOrientation(const ParticleProperty& orientations, size_t i){
+    if(orientations.dataType() == DataType::Float){
+        const float* q = orientations.dataFloat() + 4 * i;
+        return Quaternion(q[0], q[1], q[2], q[3]);
+    }
+    const double* q = orientations.dataDouble() + 4 * i;
+    return Quaternion(q[0], q[1], q[2], q[3]);
+}
+
+// Atom indices in the engines are stored with the width of Index (uint32_t or uint64_t).
+template<typename Index>
 union NodeUnion{
-    size_t opposite;
-    size_t size;
+    Index opposite;
+    Index size;
 };
 
+template<typename Index>
 struct HalfEdge{
     HalfEdge* _parent;
     HalfEdge* _left;
     HalfEdge* _right;
     int _color;
 
-    NodeUnion data;
+    NodeUnion<Index> data;
     double weight;
 };
 
@@ -119,10 +235,11 @@ inline std::vector<double> leastAbsoluteDeviations(
     return residuals;
 }  
 
+template<typename Index>
 struct rbtree_node_traits{
-    typedef HalfEdge node;
-    typedef HalfEdge* node_ptr;
-    typedef const HalfEdge* const_node_ptr;
+    typedef HalfEdge<Index> node;
+    typedef HalfEdge<Index>* node_ptr;
+    typedef const HalfEdge<Index>* const_node_ptr;
     typedef int color;
 
     static node_ptr get_parent(const_node_ptr n){
@@ -167,26 +284,206 @@ struct rbtree_node_traits{
 };
 
 struct node_ptr_compare{
-    bool operator()(const HalfEdge* a, const HalfEdge* b) const{
+    template<typename Index>
+    bool operator()(const HalfEdge<Index>* a, const HalfEdge<Index>* b) const{
         return a->data.opposite < b->data.opposite;
     }
 };
 
-typedef boost::intrusive::rbtree_algorithms<rbtree_node_traits> algo;
+template<typename Index>
+using algo = boost::intrusive::rbtree_algorithms<rbtree_node_traits<Index>>;
 
 
-static inline HalfEdge* find(HalfEdge* header, size_t index){
-    HalfEdge key;
+template<typename Index>
+static inline HalfEdge<Index>* find(HalfEdge<Index>* header, Index index){
+    HalfEdge<Index> key;
     key.data.opposite = index;
-    HalfEdge* result = algo::find(header, &key, node_ptr_compare());
+    HalfEdge<Index>* result = algo<Index>::find(header, &key, node_ptr_compare());
     return result == header ? nullptr : result;
 }
 
-static inline void insert_halfedge(HalfEdge* header, HalfEdge* edge){
-    algo::insert_equal_upper_bound(header, edge, node_ptr_compare());
+template<typename Index>
+static inline void insert_halfedge(HalfEdge<Index>* header, HalfEdge<Index>* edge){
+    algo<Index>::insert_equal_upper_bound(header, edge, node_ptr_compare());
     header->data.size++;
 }
 
+// Graph nodes still to be clustered, one bit per node with a live count. Nodes are only
+// removed once the graph is built, so the lowest live node never moves backwards and
+// first() resumes its scan at a monotone word cursor: O(1) amortised.
+template<typename Index>
+class ActiveNodeSet{
+public:
+    explicit ActiveNodeSet(size_t numNodes) : _words((numNodes + 63) / 64, 0){}
+
+    size_t size() const{
+        return _count;
+    }
+
+    bool contains(Index u) const{
+        return (_words[u >> 6] >> (u & 63)) & 1;
+    }
+
+    void insert(Index u){
+        uint64_t& word = _words[u >> 6];
+        const uint64_t bit = uint64_t(1) << (u & 63);
+        if(word & bit) return;
+        word |= bit;
+        _count++;
+        _cursor = std::min(_cursor, (size_t) (u >> 6));
+    }
+
+    void erase(Index u){
+        uint64_t& word = _words[u >> 6];
+        const uint64_t bit = uint64_t(1) << (u & 63);
+        if(!(word & bit)) return;
+        word &= ~bit;
+        _count--;
+    }
+
+    // Lowest live node; the set must not be empty.
+    Index first() const{
+        while(_words[_cursor] == 0){
+            _cursor++;
+        }
+        return (Index) (_cursor * 64 + std::countr_zero(_words[_cursor]));
+    }
+
+private:
+    std::vector<uint64_t> _words;
+    size_t _count = 0;
+    mutable size_t _cursor = 0;
+};
+
+// Two nearest neighbors of every graph node from its last adjacency scan, each with the
+// weight of the edge and the contraction stamp the neighbor had then. Node-pair-sampling
+// linkage is reducible: a merged cluster is never closer to a third node than the nearer of
+// its two halves, and ratios wnode[v] / w(a, v) only grow while w(a, v) is unchanged. So a
+// cached neighbor whose stamp is current is still the nearest, and when the nearest has
+// grown by a contraction the better of it and an untouched second neighbor still is. Edge
+// weights of a node only change when one of its neighbors is absorbed; the graphs report
+// those nodes through absorbed(), which folds the merged node into the cached pair.
+template<typename Index>
+class NearestNeighborCache{
+public:
+    explicit NearestNeighborCache(size_t numNodes) : _entries(numNodes), _stamps(numNodes, 0){}
+
+    // Nearest neighbor of a as (wnode[neighbor] / weight, neighbor) if the cache can tell.
+    bool lookup(Index a, const std::vector<double>& wnode, double& ratio, Index& neighbor){
+        Entry& entry = _entries[a];
+        if(entry.valid && !current(entry.best) && entry.hasSecond && current(entry.second)){
+            entry.best.stamp = _stamps[entry.best.node];
+            if(!closer(entry.best, entry.second, wnode)){
+                entry.best = entry.second;
+                entry.hasSecond = false;
+            }
+        }
+        if(entry.valid && current(entry.best)){
+            ratio = entry.best.ratio(wnode);
+            neighbor = entry.best.node;
+            _hits++;
+            return true;
+        }
+        _rescans++;
+        return false;
+    }
+
+    void store(Index a, Index best, double bestWeight, Index second, double secondWeight){
+        Entry& entry = _entries[a];
+        entry.best = { best, bestWeight, _stamps[best] };
+        entry.hasSecond = second != std::numeric_limits<Index>::max();
+        if(entry.hasSecond){
+            entry.second = { second, secondWeight, _stamps[second] };
+        }
+        entry.valid = true;
+    }
+
+    // b is being merged into a; called before absorbed() for the neighbors of b.
+    void contracted(Index a, Index b){
+        _stamps[a]++;
+        _stamps[b]++;
+        _entries[a].valid = false;
+        _entries[b].valid = false;
+    }
+
+    // Neighbor x of the absorbed node b now links to a with the given weight, and wnode[a]
+    // already includes b.
+    void absorbed(Index x, Index a, Index b, double weight, const std::vector<double>& wnode){
+        Entry& entry = _entries[x];
+        if(!entry.valid) return;
+
+        const Neighbor merged{ a, weight, _stamps[a] };
+        const bool keepBest = entry.best.node != a && entry.best.node != b && current(entry.best);
+        const bool keepSecond = entry.hasSecond && entry.second.node != a && entry.second.node != b && current(entry.second);
+        if(keepBest){
+            if(closer(merged, entry.best, wnode)){
+                entry.second = entry.best;
+                entry.best = merged;
+                entry.hasSecond = true;
+            }else if(keepSecond){
+                if(closer(merged, entry.second, wnode)){
+                    entry.second = merged;
+                }
+            }else{
+                entry.hasSecond = false;
+            }
+        }else if((entry.best.node == a || entry.best.node == b) && keepSecond){
+            if(closer(merged, entry.second, wnode)){
+                entry.best = merged;
+            }else{
+                entry.best = entry.second;
+                entry.hasSecond = false;
+            }
+        }else{
+            entry.valid = false;
+        }
+    }
+
+    // Lookups answered from the cache and lookups that had to rescan the adjacency.
+    size_t hits() const{
+        return _hits;
+    }
+
+    size_t rescans() const{
+        return _rescans;
+    }
+
+private:
+    struct Neighbor{
+        Index node = 0;
+        double weight = 0.0;
+        uint32_t stamp = 0;
+
+        double ratio(const std::vector<double>& wnode) const{
+            return wnode[node] / std::max(weight, 1e-300);
+        }
+    };
+
+    struct Entry{
+        Neighbor best;
+        Neighbor second;
+        bool hasSecond = false;
+        bool valid = false;
+    };
+
+    std::vector<Entry> _entries;
+    std::vector<uint32_t> _stamps;
+    size_t _hits = 0;
+    size_t _rescans = 0;
+
+    bool current(const Neighbor& n) const{
+        return n.stamp == _stamps[n.node];
+    }
+
+    // Same order as the adjacency scan: smaller ratio, then lower index.
+    static bool closer(const Neighbor& u, const Neighbor& v, const std::vector<double>& wnode){
+        const double du = u.ratio(wnode);
+        const double dv = v.ratio(wnode);
+        return du < dv || (du == dv && u.node < v.node);
+    }
+};
+
+template<typename Index>
 class DisjointSet{
 public:
     DisjointSet(size_t n){
@@ -196,14 +493,14 @@ public:
     }
 
     void clear(){
-        std::iota(parents.begin(), parents.end(), (size_t) 0);
+        std::iota(parents.begin(), parents.end(), (Index) 0);
         std::fill(sizes.begin(), sizes.end(), 1);
     }
 
     // "Find" part of Union-Find.
-    size_t find(size_t index){
+    Index find(Index index){
         // Find root and make root as parent of i (path compression)
-        size_t x = parents[index];
+        Index x = parents[index];
         while(x != parents[x]){
             parents[x] = parents[parents[x]];
             x = parents[x];
@@ -213,9 +510,9 @@ public:
     }
 
     // "Union" part of Union-Find.
-    size_t merge(size_t index1, size_t index2){
-        size_t parentA = find(index1);
-        size_t parentB = find(index2);
+    Index merge(Index index1, Index index2){
+        Index parentA = find(index1);
+        Index parentB = find(index2);
         if(parentA == parentB) return parentA;
 
         // Attach smaller tree under root of larger tree
@@ -230,26 +527,36 @@ public:
         }
     }
 
-    size_t nodesize(size_t index) const{
+    size_t nodesize(Index index) const{
         return sizes[index];
     }
     
 private:
-    std::vector<size_t> parents;
-    std::vector<size_t> sizes;
+    std::vector<Index> parents;
+    std::vector<Index> sizes;
 };
 
+// Orientations are stored with the precision of Real (float or double).
+template<typename Index, typename Real = double>
 class GrainSegmentationEngine1{
 public:
-    class Graph{
+    static constexpr Index InvalidIndex = std::numeric_limits<Index>::max();
+
+    // Graph backend with the adjacency of each node in an intrusive red-black tree of
+    // HalfEdge nodes keyed by the opposite node.
+    class TreeGraph{
     public:
+        using HalfEdge = Volt::HalfEdge<Index>;
+        using algo = Volt::algo<Index>;
+
         std::vector<double> wnode;
         std::vector<HalfEdge> header;
         std::vector<HalfEdge> edgeBuffer;
         size_t edgeCount = 0;
-        std::unordered_set<size_t> activeNodes;
+        ActiveNodeSet<Index> activeNodes;
+        NearestNeighborCache<Index> nearestCache;
 
-        Graph(size_t numNodes, size_t numEdges){
+        TreeGraph(size_t numNodes, size_t numEdges) : activeNodes(numNodes), nearestCache(numNodes){
             wnode.assign(numNodes, 0.0);
             header.resize(numNodes);
             for(size_t i = 0; i < numNodes; ++i){
@@ -263,17 +570,24 @@ public:
             return activeNodes.size();
         }
 
-        size_t next_node() const{
-            return *activeNodes.begin();
+        Index next_node() const{
+            return activeNodes.first();
         } 
 
-        std::tuple<double, size_t> nearestNeighbor(size_t a) const{
+        std::tuple<double, Index> nearestNeighbor(Index a){
             double dmin = std::numeric_limits<double>::infinity();
-            size_t vmin = std::numeric_limits<size_t>::max();
+            Index vmin = InvalidIndex;
+            if(nearestCache.lookup(a, wnode, dmin, vmin)){
+                return std::make_tuple(dmin * wnode[a], vmin);
+            }
+            double wmin = 0.0;
+            double dsecond = std::numeric_limits<double>::infinity();
+            Index vsecond = InvalidIndex;
+            double wsecond = 0.0;
 
             HalfEdge* e = header[a]._left;
-            for(size_t it = 0; it < header[a].data.size; ++it){
-                size_t v = e->data.opposite;
+            for(Index it = 0; it < header[a].data.size; ++it){
+                Index v = e->data.opposite;
                 double w = e->weight;
                 e = algo::next_node(e);
 
@@ -283,16 +597,22 @@ public:
 
                 double d = wnode[v] / std::max(w, 1e-300);
                 if(d < dmin || (d == dmin && v < vmin)){
-                    dmin = d; vmin = v;
+                    dsecond = dmin; vsecond = vmin; wsecond = wmin;
+                    dmin = d; vmin = v; wmin = w;
+                }else if(d < dsecond || (d == dsecond && v < vsecond)){
+                    dsecond = d; vsecond = v; wsecond = w;
                 }
             }
 
+            if(vmin != InvalidIndex){
+                nearestCache.store(a, vmin, wmin, vsecond, wsecond);
+            }
             return std::make_tuple(dmin * wnode[a], vmin);
         }
 
-        void add_edge(size_t u, size_t v, double w){
-            size_t nodes[2] = {u,v};
-            for(size_t idx : nodes){
+        void add_edge(Index u, Index v, double w){
+            Index nodes[2] = {u,v};
+            for(Index idx : nodes){
                 if(header[idx].data.size == 0){
                     activeNodes.insert(idx);
                 }
@@ -309,11 +629,11 @@ public:
             insert_halfedge(&header[v], e);
         }
 
-        void remove_node(size_t u){
+        void remove_node(Index u){
             activeNodes.erase(u);
         }
 
-        size_t contract_edge(size_t a, size_t b){
+        Index contract_edge(Index a, Index b){
             if(header[b].data.size > header[a].data.size){
                 std::swap(a,b);
             }
@@ -322,10 +642,12 @@ public:
             algo::unlink(find(&header[a], b));
             header[a].data.size--;
             header[b].data.size--;
+            wnode[a] += wnode[b];
+            nearestCache.contracted(a, b);
 
             HalfEdge* edge = header[b]._left;
             while(header[b].data.size != 0){
-                size_t v = edge->data.opposite;
+                Index v = edge->data.opposite;
                 double w = edge->weight;
                 HalfEdge* next = algo::next_node(edge);
                 algo::unlink(edge);
@@ -338,36 +660,477 @@ public:
                 HalfEdge* temp = find(&header[a], v);
                 if(temp){
                     temp->weight += w;
-                    find(&header[v], a)->weight += w;
+                    HalfEdge* back = find(&header[v], a);
+                    back->weight += w;
+                    nearestCache.absorbed(v, a, b, back->weight, wnode);
                 }else{
                     edge->data.opposite = v; edge->weight = w;
                     insert_halfedge(&header[a], edge);
 
                     opposite->data.opposite = a; opposite->weight = w;
                     insert_halfedge(&header[v], opposite);
+                    nearestCache.absorbed(v, a, b, w, wnode);
                 }
 
                 edge = next;
             }
 
             remove_node(b);
+            return a;
+        }
+    };
+
+    // Graph backend that keeps the adjacency of each node as an array of (neighbor, weight)
+    // entries sorted by neighbor, in one pooled arena. Node degrees are small, so linear
+    // scans and short shifts beat walking pointer-linked tree nodes. Blocks have
+    // power-of-two capacities; a node that outgrows its block moves to a larger one and
+    // the old block is reused by the next node that needs that capacity. Produces the
+    // same merge sequence as TreeGraph.
+    class FlatGraph{
+    public:
+        struct Entry{
+            Index opposite;
+            double weight;
+        };
+
+        std::vector<double> wnode;
+        ActiveNodeSet<Index> activeNodes;
+        NearestNeighborCache<Index> nearestCache;
+
+        FlatGraph(size_t numNodes, size_t numEdges) : activeNodes(numNodes), nearestCache(numNodes){
+            wnode.assign(numNodes, 0.0);
+            lists.resize(numNodes);
+            arena.reserve(2 * numEdges);
+        }
+
+        size_t num_nodes() const{
+            return activeNodes.size();
+        }
+
+        Index next_node() const{
+            return activeNodes.first();
+        }
+
+        std::tuple<double, Index> nearestNeighbor(Index a){
+            double dmin = std::numeric_limits<double>::infinity();
+            Index vmin = InvalidIndex;
+            if(nearestCache.lookup(a, wnode, dmin, vmin)){
+                return std::make_tuple(dmin * wnode[a], vmin);
+            }
+            double wmin = 0.0;
+            double dsecond = std::numeric_limits<double>::infinity();
+            Index vsecond = InvalidIndex;
+            double wsecond = 0.0;
+
+            const Entry* entries = arena.data() + lists[a].offset;
+            for(Index it = 0; it < lists[a].size; ++it){
+                Index v = entries[it].opposite;
+                double w = entries[it].weight;
+
+                if(v == a){
+                    throw std::runtime_error("Graph has self loops");
+                }
+
+                double d = wnode[v] / std::max(w, 1e-300);
+                if(d < dmin || (d == dmin && v < vmin)){
+                    dsecond = dmin; vsecond = vmin; wsecond = wmin;
+                    dmin = d; vmin = v; wmin = w;
+                }else if(d < dsecond || (d == dsecond && v < vsecond)){
+                    dsecond = d; vsecond = v; wsecond = w;
+                }
+            }
+
+            if(vmin != InvalidIndex){
+                nearestCache.store(a, vmin, wmin, vsecond, wsecond);
+            }
+            return std::make_tuple(dmin * wnode[a], vmin);
+        }
+
+        void add_edge(Index u, Index v, double w){
+            Index nodes[2] = {u,v};
+            for(Index idx : nodes){
+                if(lists[idx].size == 0){
+                    activeNodes.insert(idx);
+                }
+
+                wnode[idx] += w;
+            }
+
+            insert(u, v, w);
+            insert(v, u, w);
+        }
+
+        void remove_node(Index u){
+            activeNodes.erase(u);
+        }
+
+        Index contract_edge(Index a, Index b){
+            if(lists[b].size > lists[a].size){
+                std::swap(a,b);
+            }
+
+            erase(b, a);
+            erase(a, b);
             wnode[a] += wnode[b];
+            nearestCache.contracted(a, b);
+
+            // Every neighbor of b now points to a; no list grows, so the arena stays put.
+            const Entry* eb = arena.data() + lists[b].offset;
+            const Index nb = lists[b].size;
+            for(Index j = 0; j < nb; ++j){
+                const double w = relabel(eb[j].opposite, b, a, eb[j].weight);
+                nearestCache.absorbed(eb[j].opposite, a, b, w, wnode);
+            }
+
+            // a takes the union of both lists; shared neighbors add their weights.
+            const Entry* ea = arena.data() + lists[a].offset;
+            const Index na = lists[a].size;
+            merged.clear();
+            Index i = 0, j = 0;
+            while(i < na || j < nb){
+                if(j == nb || (i < na && ea[i].opposite < eb[j].opposite)){
+                    merged.push_back(ea[i++]);
+                }else if(i == na || eb[j].opposite < ea[i].opposite){
+                    merged.push_back(eb[j++]);
+                }else{
+                    merged.push_back({ ea[i].opposite, ea[i].weight + eb[j].weight });
+                    i++; j++;
+                }
+            }
+
+            release(lists[b]);
+            if(merged.size() > lists[a].capacity){
+                reallocate(lists[a], std::bit_ceil(merged.size()));
+            }
+            std::copy(merged.begin(), merged.end(), arena.begin() + lists[a].offset);
+            lists[a].size = (Index) merged.size();
+
+            remove_node(b);
             return a;
         }
+
+    private:
+        static constexpr size_t MinCapacity = 16;
+
+        struct AdjacencyList{
+            size_t offset = 0;
+            Index size = 0;
+            Index capacity = 0;
+        };
+
+        std::vector<AdjacencyList> lists;
+        std::vector<Entry> arena;
+        std::vector<std::vector<size_t>> freeBlocks;
+        std::vector<Entry> merged;
+
+        static size_t sizeClass(size_t capacity){
+            return std::bit_width(capacity / MinCapacity) - 1;
+        }
+
+        Entry* lowerBound(Index u, Index v){
+            Entry* entries = arena.data() + lists[u].offset;
+            return std::lower_bound(entries, entries + lists[u].size, v, [](const Entry& e, Index key){
+                return e.opposite < key;
+            });
+        }
+
+        size_t allocate(size_t capacity){
+            const size_t cls = sizeClass(capacity);
+            if(cls < freeBlocks.size() && !freeBlocks[cls].empty()){
+                const size_t offset = freeBlocks[cls].back();
+                freeBlocks[cls].pop_back();
+                return offset;
+            }
+            const size_t offset = arena.size();
+            arena.resize(offset + capacity);
+            return offset;
+        }
+
+        void release(AdjacencyList& list){
+            if(list.capacity != 0){
+                const size_t cls = sizeClass(list.capacity);
+                if(cls >= freeBlocks.size()) freeBlocks.resize(cls + 1);
+                freeBlocks[cls].push_back(list.offset);
+            }
+            list = AdjacencyList{};
+        }
+
+        // Moves the list to a block of the given capacity, keeping its entries.
+        void reallocate(AdjacencyList& list, size_t capacity){
+            const size_t offset = allocate(std::max(capacity, MinCapacity));
+            std::copy_n(arena.begin() + list.offset, list.size, arena.begin() + offset);
+            const Index size = list.size;
+            release(list);
+            list.offset = offset;
+            list.size = size;
+            list.capacity = (Index) std::max(capacity, MinCapacity);
+        }
+
+        void insert(Index u, Index v, double w){
+            if(lists[u].size == lists[u].capacity){
+                reallocate(lists[u], 2 * (size_t) lists[u].capacity);
+            }
+            Entry* entries = arena.data() + lists[u].offset;
+            Entry* pos = lowerBound(u, v);
+            std::move_backward(pos, entries + lists[u].size, entries + lists[u].size + 1);
+            *pos = { v, w };
+            lists[u].size++;
+        }
+
+        void erase(Index u, Index v){
+            Entry* entries = arena.data() + lists[u].offset;
+            Entry* pos = lowerBound(u, v);
+            std::move(pos + 1, entries + lists[u].size, pos);
+            lists[u].size--;
+        }
+
+        // Replaces the entry of v for b by one for a, adding w if v already links to a.
+        // Returns the weight of the new entry.
+        double relabel(Index v, Index b, Index a, double w){
+            Entry* entries = arena.data() + lists[v].offset;
+            Entry* end = entries + lists[v].size;
+            Entry* from = lowerBound(v, b);
+            Entry* to = lowerBound(v, a);
+            if(to != end && to->opposite == a){
+                const double merged = to->weight += w;
+                std::move(from + 1, end, from);
+                lists[v].size--;
+                return merged;
+            }else if(to <= from){
+                std::move_backward(to, from, from + 1);
+                *to = { a, w };
+            }else{
+                std::move(from + 1, to, from);
+                *(to - 1) = { a, w };
+            }
+            return w;
+        }
     };
 
+    // Compile with VOLT_FLAT_GRAPH (CMake option GRAIN_SEGMENTATION_FLAT_GRAPH) to
+    // cluster on FlatGraph instead of the red-black tree adjacency.
+#ifdef VOLT_FLAT_GRAPH
+    using Graph = FlatGraph;
+#else
+    using Graph = TreeGraph;
+#endif
+
     static constexpr int MAX_DISORDERED_NEIGHBORS = 8;
 
     struct NeighborBond{
-        size_t a;
-        size_t b;
+        Index a;
+        Index b;
         double disorientation;
-        double length;
+    };
+
+    // Bond record used while sorting the arrays by disorientation.
+    struct PackedBond{
+        float disorientation;
+        Index a;
+        Index b;
+    };
+
+    // Blocked parallel count/scan/scatter shared by the radix sorts, the bond class
+    // partition and the compactions. count() tallies bucket(i) of every element per block
+    // of blockSize elements and turns the tallies into bucket-major, block-minor output
+    // offsets, so scatter() keeps the input order within each bucket.
+    template<size_t NumBuckets>
+    class BlockedBuckets{
+    public:
+        BlockedBuckets(size_t size, size_t blockSize)
+            : _size(size)
+            , _blockSize(blockSize)
+            , _numBlocks((size + blockSize - 1) / blockSize)
+            , _offsets(_numBlocks * NumBuckets){}
+
+        template<typename Bucket>
+        void count(const Bucket& bucket){
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, _numBlocks), [&](const tbb::blocked_range<size_t>& r){
+                for(size_t block = r.begin(); block != r.end(); ++block){
+                    size_t* histogram = &_offsets[block * NumBuckets];
+                    std::fill(histogram, histogram + NumBuckets, size_t(0));
+                    const size_t end = std::min(_size, (block + 1) * _blockSize);
+                    for(size_t i = block * _blockSize; i < end; ++i){
+                        histogram[bucket(i)]++;
+                    }
+                }
+            });
+
+            size_t total = 0;
+            for(size_t b = 0; b < NumBuckets; ++b){
+                _bucketOffsets[b] = total;
+                for(size_t block = 0; block < _numBlocks; ++block){
+                    size_t& entry = _offsets[block * NumBuckets + b];
+                    const size_t n = entry;
+                    entry = total;
+                    total += n;
+                }
+            }
+            _bucketOffsets[NumBuckets] = total;
+        }
+
+        // First output position of bucket b; bucketOffset(NumBuckets) is the size.
+        size_t bucketOffset(size_t b) const{
+            return _bucketOffsets[b];
+        }
+
+        // True if all elements fell into one bucket.
+        bool uniform() const{
+            for(size_t b = 0; b < NumBuckets; ++b){
+                if(_bucketOffsets[b + 1] - _bucketOffsets[b] == _size) return true;
+            }
+            return false;
+        }
+
+        // Calls scatter(i, slot) with the output position of every element in a bucket below
+        // numScattered; elements of the later buckets are dropped.
+        template<typename Bucket, typename Scatter>
+        void scatter(const Bucket& bucket, const Scatter& scatter, size_t numScattered = NumBuckets){
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, _numBlocks), [&](const tbb::blocked_range<size_t>& r){
+                for(size_t block = r.begin(); block != r.end(); ++block){
+                    size_t* offsets = &_offsets[block * NumBuckets];
+                    const size_t end = std::min(_size, (block + 1) * _blockSize);
+                    for(size_t i = block * _blockSize; i < end; ++i){
+                        const size_t b = bucket(i);
+                        if(b < numScattered) scatter(i, offsets[b]++);
+                    }
+                }
+            });
+        }
+
+    private:
+        size_t _size;
+        size_t _blockSize;
+        size_t _numBlocks;
+        std::vector<size_t> _offsets;
+        std::array<size_t, NumBuckets + 1> _bucketOffsets{};
+    };
+
+    // Stable LSD radix sort on 8-bit digits of the low keyBits bits of key(i). Each pass
+    // hands the new position of every element to scatter(i, slot) and then calls swap()
+    // to make the scattered order current. Passes in which every key has the same digit
+    // are skipped.
+    template<typename Key, typename Scatter, typename Swap>
+    static void radixSort(size_t N, int keyBits, const Key& key, const Scatter& scatter, const Swap& swap){
+        constexpr int RadixBits = 8;
+        constexpr size_t NumBuckets = size_t(1) << RadixBits;
+
+        for(int shift = 0; shift < keyBits; shift += RadixBits){
+            auto digit = [&key, shift](size_t i){
+                return (size_t) (key(i) >> shift) & (NumBuckets - 1);
+            };
+            BlockedBuckets<NumBuckets> buckets(N, 65536);
+            buckets.count(digit);
+            if(buckets.uniform()) continue;
+            buckets.scatter(digit, scatter);
+            swap();
+        }
+    }
+
+    // Radix sort on the bit pattern of the disorientation. The values are non-negative, so
+    // their bit patterns order the same way as the floats. Ties keep their input order,
+    // which is (a, b) order for the bond table. Skipping uniform passes removes most of the
+    // high-byte passes for the narrow [0, threshold) range.
+    static void radixSortByDisorientation(std::vector<PackedBond>& bonds){
+        std::vector<PackedBond> buffer(bonds.size());
+        radixSort(bonds.size(), 32,
+            [&bonds](size_t i){ return std::bit_cast<uint32_t>(bonds[i].disorientation); },
+            [&](size_t i, size_t slot){ buffer[slot] = bonds[i]; },
+            [&]{ bonds.swap(buffer); }
+        );
+    }
+
+    // Stable radix sort of values by their keys. Only the digits up to the bit width of
+    // maxKey are sorted on, so small key ranges take one or two passes.
+    template<typename Value>
+    static void radixSortByKey(std::vector<Index>& keys, std::vector<Value>& values, Index maxKey){
+        std::vector<Index> keyBuffer(keys.size());
+        std::vector<Value> valueBuffer(keys.size());
+        radixSort(keys.size(), std::bit_width(maxKey),
+            [&keys](size_t i){ return keys[i]; },
+            [&](size_t i, size_t slot){
+                keyBuffer[slot] = keys[i];
+                valueBuffer[slot] = values[i];
+            },
+            [&]{
+                keys.swap(keyBuffer);
+                values.swap(valueBuffer);
+            }
+        );
+    }
+
+    // Symmetry the batched kernel evaluates same-type bonds of this structure with. Only
+    // types whose results are checked against PTM::calculateDisorientation are listed
+    // (tests/disorientation_kernel_test.cpp); diamond and graphene frames stay on PTM.
+    static bool crystalSymmetry(StructureType type, CrystalSymmetry& symmetry){
+        switch(PTM::toPtmStructureType(type)){
+            case PTM_MATCH_SC:
+            case PTM_MATCH_FCC:
+            case PTM_MATCH_BCC:
+                symmetry = CrystalSymmetry::Cubic;
+                return true;
+            case PTM_MATCH_HCP:
+                symmetry = CrystalSymmetry::Hexagonal;
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // Structure-of-arrays bond storage: Index-wide endpoints and single-precision
+    // disorientations, 12 bytes per bond with 32-bit indices. The graph edge weights are
+    // only filled in once the bonds are filtered and sorted.
+    struct NeighborBondArray{
+        std::vector<Index> a;
+        std::vector<Index> b;
+        std::vector<float> disorientation;
+        std::vector<double> weight;
+
+        size_t size() const{
+            return a.size();
+        }
+
+        bool empty() const{
+            return a.empty();
+        }
+
+        void resize(size_t n){
+            a.resize(n);
+            b.resize(n);
+            disorientation.resize(n);
+        }
+
+        void clear(){
+            a.clear();
+            b.clear();
+            disorientation.clear();
+            weight.clear();
+        }
+
+        NeighborBond bond(size_t i) const{
+            return { a[i], b[i], disorientation[i] };
+        }
+    };
+
+    // Per-atom neighbor lists in compressed sparse row layout. The neighbors of atom i
+    // are stored in [offsets[i], offsets[i + 1]), ordered by increasing distance.
+    struct NeighborTable{
+        std::vector<size_t> offsets;
+        std::vector<Index> indices;
+        std::vector<double> distancesSq;
+
+        size_t numParticles() const{
+            return offsets.empty() ? 0 : offsets.size() - 1;
+        }
+
+        int count(size_t i) const{
+            return (int) (offsets[i + 1] - offsets[i]);
+        }
     };
 
     struct DendrogramNode{
         DendrogramNode() = default;
-        DendrogramNode(size_t _a, size_t _b, double _distance, double _disorientation, size_t _size, const Quaternion& _orientation)
+        DendrogramNode(Index _a, Index _b, double _distance, double _disorientation, size_t _size, const Quaternion& _orientation)
             : a(_a)
             , b(_b)
             , distance(_distance)
@@ -375,19 +1138,19 @@ public:
             , size(_size)
             , merge_size(0.0)
             , orientation(_orientation){}
-        size_t a = 0;
-        size_t b = 0;
+        Index a = 0;
+        Index b = 0;
         double distance = 0.0;
         double disorientation = 0.0;
         size_t size = 0;
         double merge_size = 0.0;
-        Quaternion orientation;
+        PackedQuaternion<Real> orientation;
     };
 
     class InterfaceHandler{
     public:
         explicit InterfaceHandler(const std::shared_ptr<ParticleProperty>& structures){
-            int counts[(int) StructureType::NUM_STRUCTURE_TYPES] = {0};
+            size_t counts[(int) StructureType::NUM_STRUCTURE_TYPES] = {0};
 
             for(size_t i = 0; i < structures->size(); ++i){
                 int t = structures->getInt(i);
@@ -396,6 +1159,10 @@ public:
                 }
             }
 
+            // Interface bonds need both phases of a cubic/hex pair to be present.
+            mixed_phases = (counts[(int) StructureType::FCC] > 0 && counts[(int) StructureType::HCP] > 0)
+                || (counts[(int) StructureType::CUBIC_DIAMOND] > 0 && counts[(int) StructureType::HEX_DIAMOND] > 0);
+
             parent_fcc = counts[(int) StructureType::FCC] >= counts[(int) StructureType::HCP];
             parent_dcub = counts[(int) StructureType::CUBIC_DIAMOND] >= counts[(int) StructureType::HEX_DIAMOND];
 
@@ -420,9 +1187,13 @@ public:
             return target[(int) s];
         }
 
+        bool has_mixed_phases() const{
+            return mixed_phases;
+        }
+
         bool reorder_bond(NeighborBond& bond, const std::vector<StructureType>& types) const{
-            size_t a = bond.a;
-            size_t b = bond.b;
+            Index a = bond.a;
+            Index b = bond.b;
 
             auto sa = types[a];
             auto sb = types[b];
@@ -449,11 +1220,70 @@ public:
         }
 
     private:
+        bool mixed_phases = false;
         bool parent_fcc  = true;
         bool parent_dcub = true;
         StructureType target[(int) StructureType::NUM_STRUCTURE_TYPES];
     };
 
+    // Monotone bucket queue for the serial interface pass. Keys lie in [0, maxKey) and are
+    // spread over equal-width buckets, each a binary heap on (disorientation, a, b). Keys
+    // pushed below the cursor land in the cursor bucket and keys at or above maxKey in the
+    // last one, so pops follow (disorientation, a, b) order, while every heap stays small.
+    class InterfaceQueue{
+    public:
+        struct Entry{
+            double disorientation;
+            Index a;
+            Index b;
+        };
+
+        explicit InterfaceQueue(double maxKey, size_t numBuckets = 256)
+            : _buckets(numBuckets)
+            , _scale(numBuckets / maxKey){}
+
+        bool empty() const{
+            return _size == 0;
+        }
+
+        void push(const Entry& entry){
+            if(std::isnan(entry.disorientation)){
+                throw std::runtime_error("Interface queue key is not a number.");
+            }
+            const double scaled = std::clamp(entry.disorientation * _scale, 0.0, (double) (_buckets.size() - 1));
+            const size_t bucket = std::max((size_t) scaled, _cursor);
+            auto& heap = _buckets[bucket];
+            heap.push_back(entry);
+            std::push_heap(heap.begin(), heap.end(), later);
+            ++_size;
+        }
+
+        Entry pop(){
+            if(empty()){
+                throw std::runtime_error("Pop from an empty interface queue.");
+            }
+            while(_buckets[_cursor].empty()) ++_cursor;
+            auto& heap = _buckets[_cursor];
+            std::pop_heap(heap.begin(), heap.end(), later);
+            const Entry entry = heap.back();
+            heap.pop_back();
+            --_size;
+            return entry;
+        }
+
+    private:
+        static bool later(const Entry& x, const Entry& y){
+            if(x.disorientation != y.disorientation) return x.disorientation > y.disorientation;
+            if(x.a != y.a) return x.a > y.a;
+            return x.b > y.b;
+        }
+
+        std::vector<std::vector<Entry>> _buckets;
+        double _scale;
+        size_t _cursor = 0;
+        size_t _size = 0;
+    };
+
     class Regressor{
     public:
         double gradient = 0;
@@ -516,30 +1346,130 @@ public:
     , _simCell(*simCell)
     , _outputBonds(outputBonds)
     {
+        if(_numParticles >= (size_t) InvalidIndex){
+            throw std::runtime_error("Too many particles for the engine index type.");
+        }
+
         _adjustedStructureTypes.resize(_numParticles, StructureType::OTHER);
         _adjustedOrientations.resize(_numParticles);
 
         for(size_t i=0;i<_numParticles;++i){
             _adjustedStructureTypes[i] = (StructureType)_structuresProperty->getInt(i);
-            const double* q = _orientationsProperty->dataDouble() + 4 * i;
-            _adjustedOrientations[i] = Quaternion(q[0], q[1], q[2], q[3]);
-            _adjustedOrientations[i].normalize();
+            _adjustedOrientations[i] = propertyOrientation(*_orientationsProperty, i).normalized();
         }
+
+        _interfaceHandler.emplace(_structuresProperty);
     }
 
-    void perform(){
-        createNeighborBonds();
-        rotateInterfaceAtoms();
-        computeDisorientationAngles();
+    // Reuses the neighbor lists found by the PTM stage, so only rows too short for the
+    // atom's type are searched again.
+    GrainSegmentationEngine1(
+        std::shared_ptr<ParticleProperty> positions,
+        std::shared_ptr<ParticleProperty> structures,
+        std::shared_ptr<ParticleProperty> orientations,
+        std::shared_ptr<ParticleProperty> correspondences,
+        const SimulationCell* simCell,
+        NeighborTable neighbors,
+        bool handleCoherentInterfaces,
+        bool outputBonds
+    )
+    : GrainSegmentationEngine1(
+        std::move(positions),
+        std::move(structures),
+        std::move(orientations),
+        std::move(correspondences),
+        simCell,
+        handleCoherentInterfaces,
+        outputBonds
+    ){
+        if(neighbors.numParticles() != _numParticles){
+            throw std::runtime_error("Neighbor table does not match the number of particles.");
+        }
+        _neighbors = std::move(neighbors);
+    }
+
+    void perform(){
+        createNeighborBonds();
+        rotateInterfaceAtoms();
+        _neighbors = NeighborTable{};
+
+        computeDisorientationAngles();
         determineMergeSequence();
 
         _positions.reset();
     }
 
+    // Search used to build the neighbor table when none was passed to the constructor.
+    void setNeighborBackend(NeighborSearchBackend backend){
+        _neighborBackend = backend;
+    }
+
+    // Rows of the neighbor table found by the spatial search rather than passed in.
+    size_t searchedNeighborRows() const{
+        return _searchedNeighborRows;
+    }
+
+    // The serial order is kept for validating the parallel propagation.
+    void setInterfacePropagation(InterfacePropagation propagation){
+        _interfacePropagation = propagation;
+    }
+
+    // Opt-in cache of the interface disorientations of the bond table across the coherent-
+    // interface pass and the final bond evaluation.
+    void setInterfaceCache(bool enabled){
+        _interfaceCacheEnabled = enabled;
+    }
+
+    void setDisorientationMode(DisorientationMode mode){
+        _disorientationMode = mode;
+    }
+
+    void setClusteringMode(ClusteringMode mode){
+        _clusteringMode = mode;
+    }
+
     const std::vector<DendrogramNode>& dendrogram() const{
         return _dendrogram;
     }
 
+    // After perform(): the crystalline bonds below the misorientation threshold, sorted by
+    // disorientation.
+    const NeighborBondArray& neighborBonds() const{
+        return _neighborBonds;
+    }
+
+    // Interface cache: disorientations served from the cache and computed afresh.
+    size_t interfaceCacheHits() const{
+        return _interfaceCacheHits.load(std::memory_order_relaxed);
+    }
+
+    size_t interfaceCacheMisses() const{
+        return _interfaceCacheMisses.load(std::memory_order_relaxed);
+    }
+
+    // Approximate mode: bonds taken from the lookup table and bonds evaluated exactly.
+    size_t approximatedBonds() const{
+        return _approximatedBonds.load(std::memory_order_relaxed);
+    }
+
+    size_t exactFallbacks() const{
+        return _exactFallbacks.load(std::memory_order_relaxed);
+    }
+
+    // Chain clustering: nearest-neighbor lookups served from the per-node cache and lookups
+    // that rescanned the adjacency of the node.
+    size_t nearestNeighborHits() const{
+        return _nearestNeighborHits.load(std::memory_order_relaxed);
+    }
+
+    size_t nearestNeighborRescans() const{
+        return _nearestNeighborRescans.load(std::memory_order_relaxed);
+    }
+
+    InterfacePass interfacePass() const{
+        return _interfacePass;
+    }
+
     double suggestedMergingThreshold() const{
         return _suggestedMergingThreshold;
     }
@@ -552,6 +1482,16 @@ public:
         return _orientationsProperty;
     }
 
+    static inline int desired_ptm_neighbor_count(StructureType st, int available){
+        if(st == StructureType::OTHER){
+            return std::min(available, MAX_DISORDERED_NEIGHBORS);
+        }
+
+        int ptmType = PTM::toPtmStructureType(st);
+        int want = ptm_num_nbrs[ptmType];
+        return std::min(available, want);
+    } 
+
 private:
     // TODO: Duplicated
     static inline Matrix3 quaternionToMatrix(const Quaternion& q){
@@ -630,63 +1570,179 @@ private:
         return ang_deg;
     }
 
-    static inline double calculateGraphWeight(double theta_deg){
-        if(theta_deg < 1e-5){
-            theta_deg = 0.0;
-        }
-
-        return std::exp(-(1.0/3.0) * theta_deg * theta_deg);
+    // Turns per-atom counts into CSR offsets with offsets[0] = 0 and offsets[n] = total.
+    static void exclusiveScan(const std::vector<int>& counts, std::vector<size_t>& offsets){
+        const size_t n = counts.size();
+        offsets.resize(n + 1);
+        offsets[0] = 0;
+
+        tbb::parallel_scan(tbb::blocked_range<size_t>(0, n, 4096), size_t(0),
+            [&](const tbb::blocked_range<size_t>& r, size_t sum, bool isFinalScan){
+                for(size_t i = r.begin(); i != r.end(); ++i){
+                    sum += (size_t) counts[i];
+                    if(isFinalScan){
+                        offsets[i + 1] = sum;
+                    }
+                }
+                return sum;
+            },
+            std::plus<size_t>()
+        );
     }
 
-    static inline int desired_ptm_neighbor_count(StructureType st, int available){
-        if(st == StructureType::OTHER){
-            return std::min(available, MAX_DISORDERED_NEIGHBORS);
+private:
+    // Builds the per-atom neighbor table with a single spatial search. It is shared by
+    // bond creation and the coherent interface pass. If atoms is not empty, only their
+    // rows are searched and the other rows of the table are kept.
+    void buildNeighborTable(const std::vector<Index>& atoms = {}){
+        if(_neighborBackend == NeighborSearchBackend::CellList){
+            CellListNeighborFinder cellList;
+            if(cellList.prepare(_positions->constDataPoint3(), _numParticles, _simCell, PTM::MAX_INPUT_NEIGHBORS)){
+                fillNeighborTable<CellListNeighborFinder::Query<PTM::MAX_INPUT_NEIGHBORS>>(cellList, atoms);
+                return;
+            }
+            // Degenerate cells fall back to the tree search.
         }
 
-        int ptmType = PTM::toPtmStructureType(st);
-        int want = ptm_num_nbrs[ptmType];
-        return std::min(available, want);
-    } 
-
-private:
-    void createNeighborBonds(){
         PTM neighFinder;
         if(!neighFinder.prepare(_positions->constDataPoint3(), _numParticles, _simCell)){
             throw std::runtime_error("Error trying to prepare PTM neighbor finder.");
         }
+        fillNeighborTable<NearestNeighborFinder::Query<PTM::MAX_INPUT_NEIGHBORS>>(neighFinder, atoms);
+    }
+
+    template<typename BaseQuery, typename Finder>
+    void fillNeighborTable(const Finder& neighFinder, const std::vector<Index>& atoms){
+        constexpr size_t stride = PTM::MAX_INPUT_NEIGHBORS;
+        const bool everyAtom = atoms.empty();
+        const size_t numSearched = everyAtom ? _numParticles : atoms.size();
+        std::vector<Index> indices(numSearched * stride);
+        std::vector<double> distancesSq(numSearched * stride);
+        std::vector<int> found(numSearched);
 
-        using BaseQuery = NearestNeighborFinder::Query<PTM::MAX_INPUT_NEIGHBORS>;
         tbb::enumerable_thread_specific<BaseQuery> baseQueries([&]{
             return BaseQuery(neighFinder);
         });
 
-        tbb::enumerable_thread_specific<std::vector<NeighborBond>> tlsBonds;
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, numSearched, 1024), [&](const tbb::blocked_range<std::size_t>& r){
+            auto& base = baseQueries.local();
+
+            for(size_t k = r.begin(); k != r.end(); ++k){
+                base.findNeighbors(everyAtom ? k : (size_t) atoms[k]);
+                const auto& res = base.results();
+                int available = std::min((int) res.size(), (int) stride);
+
+                for(int j = 0; j < available; ++j){
+                    indices[k * stride + j] = (Index) res[j].index;
+                    distancesSq[k * stride + j] = res[j].distanceSq;
+                }
+                found[k] = available;
+            }
+        }, tbb::auto_partitioner{});
+
+        // searched[i] is the search result of atom i, or InvalidIndex to keep its old row.
+        std::vector<Index> searched(_numParticles, InvalidIndex);
+        for(size_t k = 0; k < numSearched; ++k){
+            searched[everyAtom ? k : (size_t) atoms[k]] = (Index) k;
+        }
+
+        std::vector<int> counts(_numParticles);
+        for(size_t i = 0; i < _numParticles; ++i){
+            counts[i] = searched[i] != InvalidIndex ? found[searched[i]] : _neighbors.count(i);
+        }
+
+        NeighborTable table;
+        exclusiveScan(counts, table.offsets);
+        table.indices.resize(table.offsets[_numParticles]);
+        table.distancesSq.resize(table.offsets[_numParticles]);
 
         tbb::parallel_for(tbb::blocked_range<std::size_t>(0, _numParticles, 1024), [&](const tbb::blocked_range<std::size_t>& r){
-            auto& base = baseQueries.local();
-            auto& out = tlsBonds.local();
+            for(size_t i = r.begin(); i != r.end(); ++i){
+                if(searched[i] != InvalidIndex){
+                    const size_t first = (size_t) searched[i] * stride;
+                    std::copy_n(&indices[first], counts[i], &table.indices[table.offsets[i]]);
+                    std::copy_n(&distancesSq[first], counts[i], &table.distancesSq[table.offsets[i]]);
+                }else{
+                    std::copy_n(&_neighbors.indices[_neighbors.offsets[i]], counts[i], &table.indices[table.offsets[i]]);
+                    std::copy_n(&_neighbors.distancesSq[_neighbors.offsets[i]], counts[i], &table.distancesSq[table.offsets[i]]);
+                }
+            }
+        }, tbb::auto_partitioner{});
+
+        _neighbors = std::move(table);
+    }
+
+    // A neighbor table passed to the constructor may hold rows shorter than the engine
+    // takes for the atom's type, e.g. for atoms PTM could not match. Only those rows are
+    // searched again.
+    void completeNeighborTable(){
+        std::vector<Index> shortRows;
+        for(size_t i = 0; i < _numParticles; ++i){
+            const StructureType st = (StructureType) _structuresProperty->getInt(i);
+            if(_neighbors.count(i) < desired_ptm_neighbor_count(st, PTM::MAX_INPUT_NEIGHBORS)){
+                shortRows.push_back((Index) i);
+            }
+        }
+        _searchedNeighborRows = shortRows.size();
+        if(!shortRows.empty()){
+            buildNeighborTable(shortRows);
+        }
+    }
 
+    // Number of bonds atom i owns, i.e. bonds to neighbors with a larger index.
+    int countOwnedBonds(size_t i) const{
+        StructureType st = (StructureType) _structuresProperty->getInt(i);
+        int num = desired_ptm_neighbor_count(st, _neighbors.count(i));
+
+        const size_t first = _neighbors.offsets[i];
+        int owned = 0;
+        for(int j = 0; j < num; ++j){
+            owned += (i < _neighbors.indices[first + j]) ? 1 : 0;
+        }
+        return owned;
+    }
+
+    // Bonds are stored in compressed sparse row order: the bonds owned by atom i occupy
+    // [_bondOffsets[i], _bondOffsets[i + 1]) in increasing order of the other endpoint, so
+    // the table is in (a, b) order independent of scheduling.
+    void createNeighborBonds(){
+        if(_neighbors.numParticles() != _numParticles){
+            buildNeighborTable();
+            _searchedNeighborRows = _numParticles;
+        }else{
+            completeNeighborTable();
+        }
+
+        std::vector<int> counts(_numParticles);
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, _numParticles, 1024), [&](const tbb::blocked_range<std::size_t>& r){
             for(size_t i = r.begin(); i != r.end(); ++i){
-                base.findNeighbors(i);
-                const auto& res = base.results();
-                int available = (int) res.size();
+                counts[i] = countOwnedBonds(i);
+            }
+        }, tbb::auto_partitioner{});
 
+        exclusiveScan(counts, _bondOffsets);
+        _neighborBonds.clear();
+        _neighborBonds.resize(_bondOffsets[_numParticles]);
+
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, _numParticles, 1024), [&](const tbb::blocked_range<std::size_t>& r){
+            for(size_t i = r.begin(); i != r.end(); ++i){
                 StructureType st = (StructureType) _structuresProperty->getInt(i);
-                int num = desired_ptm_neighbor_count(st, available);
+                int num = desired_ptm_neighbor_count(st, _neighbors.count(i));
 
+                const size_t first = _neighbors.offsets[i];
+                size_t out = _bondOffsets[i];
                 for(int j = 0; j < num; ++j){
-                    size_t nb = res[j].index;
+                    Index nb = _neighbors.indices[first + j];
                     if(i < nb){
-                        double length = std::sqrt(res[j].distanceSq);
-                        out.push_back({ i, nb, std::numeric_limits<double>::infinity(), length });
+                        _neighborBonds.a[out] = (Index) i;
+                        _neighborBonds.b[out] = nb;
+                        _neighborBonds.disorientation[out] = std::numeric_limits<float>::infinity();
+                        out++;
                     }
                 }
+                std::sort(_neighborBonds.b.begin() + _bondOffsets[i], _neighborBonds.b.begin() + out);
             }
         }, tbb::auto_partitioner{});
-
-        tlsBonds.combine_each([&](const std::vector<NeighborBond>& v){
-            _neighborBonds.insert(_neighborBonds.end(), v.begin(), v.end());
-        });
     }
 
     // coherent interfaces
@@ -696,125 +1752,538 @@ private:
             return false;
         }
 
-        size_t a = bond.a;
-        size_t b = bond.b;
+        Index a = bond.a;
+        Index b = bond.b;
 
         const StructureType sa = _adjustedStructureTypes[a];
         const StructureType sb = _adjustedStructureTypes[b];
 
         Quaternion qrot;
-        double mis = PTM::calculateInterfacialDisorientation(sa, sb, _adjustedOrientations[a], _adjustedOrientations[b], qrot);
+        double mis = PTM::calculateInterfacialDisorientation(sa, sb, _adjustedOrientations[a].quaternion(), _adjustedOrientations[b].quaternion(), qrot);
         bond.disorientation = mis;
         outRot = qrot;
         return mis < _misorientationThresholdDeg;
     }
 
-    void rotateInterfaceAtoms(){
-        if(!_handleBoundaries) return;
-        if(_neighborBonds.empty()) createNeighborBonds();
+    static constexpr size_t NoBond = std::numeric_limits<size_t>::max();
+
+    // Index of the bond between a and b in the CSR bond table, or NoBond.
+    size_t findBond(Index a, Index b) const{
+        const Index lo = std::min(a, b);
+        const Index hi = std::max(a, b);
+        const auto first = _neighborBonds.b.begin() + _bondOffsets[lo];
+        const auto last = _neighborBonds.b.begin() + _bondOffsets[lo + 1];
+        const auto it = std::lower_bound(first, last, hi);
+        return (it != last && *it == hi) ? (size_t) (it - _neighborBonds.b.begin()) : NoBond;
+    }
 
-        InterfaceHandler iface(_structuresProperty);
+    // Types only change into the parent phase, so a bond can only ever be an interface
+    // bond if it starts with an endpoint outside the parent phase. Only those bonds get a
+    // slot in the flat cache.
+    void prepareInterfaceCache(const InterfaceHandler& iface){
+        auto slotted = [&](size_t i){
+            const StructureType sa = _adjustedStructureTypes[_neighborBonds.a[i]];
+            const StructureType sb = _adjustedStructureTypes[_neighborBonds.b[i]];
+            return (iface.parent_phase(sa) != sa || iface.parent_phase(sb) != sb) ? size_t(0) : size_t(1);
+        };
+        BlockedBuckets<2> buckets(_neighborBonds.size(), 16384);
+        buckets.count(slotted);
+
+        _interfaceSlots.assign(_neighborBonds.size(), NoBond);
+        buckets.scatter(slotted, [this](size_t i, size_t slot){
+            _interfaceSlots[i] = slot;
+        }, 1);
+        _interfaceCache.assign(buckets.bucketOffset(1), CachedInterface{});
+    }
 
-        PTM neighFinder;
-        if(!neighFinder.prepare(_positions->constDataPoint3(), _numParticles, _simCell)){
-            throw std::runtime_error("Error trying to prepare PTM neighbor finder.");
+    // interface_cubic_hex with the result cached per bond of the bond table while the cache
+    // is prepared. Pairs that are not a cubic/hex interface are rejected before the cache is
+    // touched, and pairs outside the bond table are always computed. Entries never go stale:
+    // only the child atom of an accepted pair is ever rotated, which moves it into the
+    // parent phase, so the pair is rejected from then on. Parallel callers touch every
+    // entry from one thread only: seeding and the final evaluation visit each bond once, a
+    // round has one winner per target, and the expansion of two rotated atoms can only meet
+    // on the bond between them, which is rejected as both share a phase.
+    bool cachedInterface(NeighborBond& bond, const InterfaceHandler& iface, Quaternion& outRot, size_t bondIndex = NoBond){
+        if(_interfaceSlots.empty()){
+            return interface_cubic_hex(bond, iface, outRot);
         }
 
-        using BaseQuery = NearestNeighborFinder::Query<PTM::MAX_INPUT_NEIGHBORS>;
-        BaseQuery base(neighFinder);
+        NeighborBond reordered = bond;
+        if(!iface.reorder_bond(reordered, _adjustedStructureTypes)){
+            bond.disorientation = std::numeric_limits<double>::infinity();
+            return false;
+        }
 
-        struct PQCmp{
-            bool operator()(const NeighborBond& a, const NeighborBond& b) const{
-                return a.disorientation > b.disorientation; 
-            }
-        };
+        if(bondIndex == NoBond) bondIndex = findBond(bond.a, bond.b);
+        const size_t slot = (bondIndex == NoBond) ? NoBond : _interfaceSlots[bondIndex];
+        if(slot == NoBond){
+            _interfaceCacheMisses.fetch_add(1, std::memory_order_relaxed);
+            return interface_cubic_hex(bond, iface, outRot);
+        }
+
+        CachedInterface& cached = _interfaceCache[slot];
+        if(cached.computed){
+            _interfaceCacheHits.fetch_add(1, std::memory_order_relaxed);
+            bond = reordered;
+            bond.disorientation = cached.disorientation;
+            outRot = cached.rotation;
+            return cached.isInterface;
+        }
+
+        _interfaceCacheMisses.fetch_add(1, std::memory_order_relaxed);
+        cached.isInterface = interface_cubic_hex(bond, iface, cached.rotation);
+        cached.disorientation = bond.disorientation;
+        cached.computed = true;
+        outRot = cached.rotation;
+        return cached.isInterface;
+    }
+
+    void releaseInterfaceCache(){
+        _interfaceSlots = std::vector<size_t>();
+        _interfaceCache = std::vector<CachedInterface>();
+    }
 
-        std::priority_queue<NeighborBond, std::vector<NeighborBond>, PQCmp> pq;
+    void rotateInterfaceAtoms(){
+        if(!_handleBoundaries){
+            _interfacePass = InterfacePass::Disabled;
+            return;
+        }
+
+        // Structure types only ever change into their parent phase, so without both
+        // phases of a pair no interface bond can appear during the pass either.
+        const InterfaceHandler& iface = *_interfaceHandler;
+        if(!iface.has_mixed_phases()){
+            _interfacePass = InterfacePass::Skipped;
+            return;
+        }
+
+        _interfacePass = InterfacePass::Performed;
+        if(_neighborBonds.empty()) createNeighborBonds();
+        if(_interfaceCacheEnabled) prepareInterfaceCache(iface);
+
+        if(_interfacePropagation == InterfacePropagation::Parallel){
+            rotateInterfaceAtomsParallel(iface);
+        }else{
+            rotateInterfaceAtomsSerial(iface);
+        }
+    }
+
+    void rotateInterfaceAtomsSerial(const InterfaceHandler& iface){
+        InterfaceQueue queue(_misorientationThresholdDeg);
+        auto push = [&queue](const NeighborBond& bond){
+            queue.push({ bond.disorientation, bond.a, bond.b });
+        };
 
-        for(auto b : _neighborBonds){
+        for(size_t i = 0; i < _neighborBonds.size(); ++i){
+            auto b = _neighborBonds.bond(i);
             Quaternion rot;
-            if(interface_cubic_hex(b, iface, rot)){
-                pq.push(b);
+            if(cachedInterface(b, iface, rot, i)){
+                push(b);
             }
         }
 
-        while(!pq.empty()){
-            auto bond = pq.top(); 
-            pq.pop();
+        while(!queue.empty()){
+            const auto entry = queue.pop();
+            NeighborBond bond{ entry.a, entry.b, entry.disorientation };
 
             Quaternion rotated;
-            if(!interface_cubic_hex(bond, iface, rotated)) continue;
+            if(!cachedInterface(bond, iface, rotated)) continue;
 
             // defect 
-            size_t idx = bond.b; 
+            Index idx = bond.b; 
             _adjustedStructureTypes[idx] = iface.parent_phase(_adjustedStructureTypes[idx]);
             _adjustedOrientations[idx]   = rotated;
 
-            base.findNeighbors(idx);
-            const auto& res = base.results();
-            int available = (int) res.size();
-            int num = desired_ptm_neighbor_count(_adjustedStructureTypes[idx], available);
+            int num = desired_ptm_neighbor_count(_adjustedStructureTypes[idx], _neighbors.count(idx));
 
+            const size_t first = _neighbors.offsets[idx];
             for(int j = 0;j < num; ++j){
-                size_t nb = res[j].index;
-                NeighborBond b2{ idx, nb, 0.0, std::sqrt(res[j].distanceSq) };
-                if(interface_cubic_hex(b2, iface, rotated)){
-                    pq.push(b2);
+                Index nb = _neighbors.indices[first + j];
+                NeighborBond b2{ idx, nb, 0.0 };
+                if(cachedInterface(b2, iface, rotated)){
+                    push(b2);
                 }
             }
         }
     }
 
-    // Misorientations
-    bool isCrystallineBond(const NeighborBond& b) const{
-        auto a = _adjustedStructureTypes[b.a];
-        auto c = _adjustedStructureTypes[b.b];
+    // Processes the interface bonds in disorientation bands of width _interfaceBandWidthDeg.
+    // Each round takes every pending bond of the current band, lets each defect atom keep
+    // its lowest (disorientation, source) bond, rotates all winners at once and queues the
+    // bonds to their neighbors. Sources are always in the parent phase and targets never
+    // are, so the atoms read and written within a round are disjoint.
+    void rotateInterfaceAtomsParallel(const InterfaceHandler& iface){
+        tbb::enumerable_thread_specific<std::vector<NeighborBond>> found;
+        auto collect = [&found](std::vector<NeighborBond>& out){
+            for(auto& local : found){
+                out.insert(out.end(), local.begin(), local.end());
+                local.clear();
+            }
+        };
 
-        if(a == StructureType::OTHER) return false;
-        if(c == StructureType::OTHER) return false;
-        if(a == c) return true;
-        if(!_handleBoundaries) return false;
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, _neighborBonds.size(), 1024), [&](const tbb::blocked_range<size_t>& r){
+            auto& local = found.local();
+            for(size_t i = r.begin(); i != r.end(); ++i){
+                auto bond = _neighborBonds.bond(i);
+                Quaternion rot;
+                if(cachedInterface(bond, iface, rot, i)){
+                    local.push_back(bond);
+                }
+            }
+        });
 
-        if((a == StructureType::FCC && c == StructureType::HCP) || (a == StructureType::HCP && c == StructureType::FCC)) return true;
-        if((a == StructureType::CUBIC_DIAMOND && c == StructureType::HEX_DIAMOND) || (a == StructureType::HEX_DIAMOND && c == StructureType::CUBIC_DIAMOND)) return true;
-        return false;
+        std::vector<NeighborBond> pending;
+        collect(pending);
+
+        std::vector<NeighborBond> current;
+        std::vector<NeighborBond> deferred;
+        std::vector<Quaternion> rotations;
+        double bandEnd = 0.0;
+        while(!pending.empty()){
+            bandEnd += _interfaceBandWidthDeg;
+
+            for(;;){
+                // The frontier splits in parallel into the bonds of the current band, the
+                // later bonds and the bonds whose target has been rotated since they were
+                // queued, which are dropped.
+                auto frontier = [&](size_t k){
+                    const NeighborBond& bond = pending[k];
+                    const StructureType target = _adjustedStructureTypes[bond.b];
+                    if(iface.parent_phase(target) == target) return size_t(2);
+                    return bond.disorientation < bandEnd ? size_t(0) : size_t(1);
+                };
+                BlockedBuckets<3> buckets(pending.size(), 4096);
+                buckets.count(frontier);
+                const size_t numCurrent = buckets.bucketOffset(1);
+                current.resize(numCurrent);
+                deferred.resize(buckets.bucketOffset(2) - numCurrent);
+                buckets.scatter(frontier, [&](size_t k, size_t slot){
+                    if(slot < numCurrent){
+                        current[slot] = pending[k];
+                    }else{
+                        deferred[slot - numCurrent] = pending[k];
+                    }
+                }, 2);
+                pending.swap(deferred);
+                if(current.empty()) break;
+
+                // One winner per target atom, independent of the order bonds were found in.
+                tbb::parallel_sort(current.begin(), current.end(), [](const NeighborBond& x, const NeighborBond& y){
+                    if(x.b != y.b) return x.b < y.b;
+                    if(x.disorientation != y.disorientation) return x.disorientation < y.disorientation;
+                    return x.a < y.a;
+                });
+                current.erase(std::unique(current.begin(), current.end(), [](const NeighborBond& x, const NeighborBond& y){
+                    return x.b == y.b;
+                }), current.end());
+
+                rotations.resize(current.size());
+                tbb::parallel_for(tbb::blocked_range<size_t>(0, current.size(), 256), [&](const tbb::blocked_range<size_t>& r){
+                    for(size_t k = r.begin(); k != r.end(); ++k){
+                        NeighborBond bond = current[k];
+                        cachedInterface(bond, iface, rotations[k]);
+                    }
+                });
+
+                tbb::parallel_for(tbb::blocked_range<size_t>(0, current.size(), 1024), [&](const tbb::blocked_range<size_t>& r){
+                    for(size_t k = r.begin(); k != r.end(); ++k){
+                        const Index idx = current[k].b;
+                        _adjustedStructureTypes[idx] = iface.parent_phase(_adjustedStructureTypes[idx]);
+                        _adjustedOrientations[idx] = rotations[k];
+                    }
+                });
+
+                tbb::parallel_for(tbb::blocked_range<size_t>(0, current.size(), 256), [&](const tbb::blocked_range<size_t>& r){
+                    auto& local = found.local();
+                    for(size_t k = r.begin(); k != r.end(); ++k){
+                        const Index idx = current[k].b;
+                        const int num = desired_ptm_neighbor_count(_adjustedStructureTypes[idx], _neighbors.count(idx));
+                        const size_t first = _neighbors.offsets[idx];
+                        for(int j = 0; j < num; ++j){
+                            NeighborBond bond{ idx, _neighbors.indices[first + j], 0.0 };
+                            Quaternion rot;
+                            if(cachedInterface(bond, iface, rot)){
+                                local.push_back(bond);
+                            }
+                        }
+                    }
+                });
+                collect(pending);
+            }
+        }
     }
 
-    void computeDisorientationAngles(){
-        if(_neighborBonds.empty()) createNeighborBonds();
+    // Fundamental-zone copies of the final orientations. Neighboring atoms of one grain
+    // then differ by a small rotation, so the batched kernel rarely needs its operator search.
+    // The approximate mode keeps only quantized copies of the symmetric atoms.
+    void reduceOrientationsToFundamentalZone(){
+        const bool approximate = _disorientationMode == DisorientationMode::Approximate;
+        if(approximate){
+            _quantizedOrientations.resize(_numParticles);
+        }else{
+            _reducedOrientations.resize(_numParticles);
+        }
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, _numParticles, 4096), [&](const tbb::blocked_range<size_t>& r){
+            for(size_t i = r.begin(); i != r.end(); ++i){
+                const PackedQuaternion<Real>& q = _adjustedOrientations[i];
+                CrystalSymmetry symmetry;
+                if(!crystalSymmetry(_adjustedStructureTypes[i], symmetry)){
+                    if(!approximate) _reducedOrientations[i] = q;
+                    continue;
+                }
+                double reduced[4] = { q.x, q.y, q.z, q.w };
+                reduceToFundamentalZone(symmetry, reduced);
+                if(approximate){
+                    _quantizedOrientations[i] = quantizeOrientation(reduced);
+                }else{
+                    _reducedOrientations[i] = Quaternion(reduced[0], reduced[1], reduced[2], reduced[3]);
+                }
+            }
+        });
+    }
+
+    // Bond classes in the order computeDisorientationAngles partitions them. Bonds of the
+    // last class can never become graph edges and are not evaluated at all.
+    enum class BondClass : uint8_t{
+        Cubic,              // Same-type bonds of cubic symmetry.
+        Hexagonal,          // Same-type bonds of hexagonal symmetry.
+        OtherCrystalline,   // Same-type bonds without a batched kernel (e.g. ICO, diamond).
+        Interface,          // FCC/HCP or cubic/hex diamond bonds.
+        NonCrystalline
+    };
+
+    static constexpr size_t NumBondClasses = 5;
+
+    // Misorientations
+    BondClass classifyBond(Index ia, Index ib, bool interfaces) const{
+        auto a = _adjustedStructureTypes[ia];
+        auto c = _adjustedStructureTypes[ib];
+
+        if(a == StructureType::OTHER || c == StructureType::OTHER) return BondClass::NonCrystalline;
+        if(a == c){
+            CrystalSymmetry symmetry;
+            if(!crystalSymmetry(a, symmetry)) return BondClass::OtherCrystalline;
+            return (symmetry == CrystalSymmetry::Cubic) ? BondClass::Cubic : BondClass::Hexagonal;
+        }
+        if(!interfaces) return BondClass::NonCrystalline;
+
+        if((a == StructureType::FCC && c == StructureType::HCP) || (a == StructureType::HCP && c == StructureType::FCC)) return BondClass::Interface;
+        if((a == StructureType::CUBIC_DIAMOND && c == StructureType::HEX_DIAMOND) || (a == StructureType::HEX_DIAMOND && c == StructureType::CUBIC_DIAMOND)) return BondClass::Interface;
+        return BondClass::NonCrystalline;
+    }
+
+    // Classifies every bond and lists the bond indices grouped by class, so each class is
+    // a contiguous range [_bondClassOffsets[c], _bondClassOffsets[c + 1]) of bondByClass().
+    // Blocked parallel counting sort; within a class the bonds keep their CSR order. The
+    // indices are stored in 32 bits unless the table has more bonds than that can address.
+    void partitionBondsByClass(bool interfaces){
         const size_t N = _neighborBonds.size();
+        _bondClasses.resize(N);
 
-        InterfaceHandler iface(_structuresProperty);
+        BlockedBuckets<NumBondClasses> buckets(N, 16384);
+        buckets.count([&](size_t i){
+            const BondClass bondClass = classifyBond(_neighborBonds.a[i], _neighborBonds.b[i], interfaces);
+            _bondClasses[i] = bondClass;
+            return (size_t) bondClass;
+        });
+        for(size_t bondClass = 0; bondClass <= NumBondClasses; ++bondClass){
+            _bondClassOffsets[bondClass] = buckets.bucketOffset(bondClass);
+        }
 
-        tbb::parallel_for(tbb::blocked_range<size_t>(0, N, 1024), [&](const tbb::blocked_range<size_t>& r){
-            for(size_t i = r.begin(); i != r.end(); ++i){
-                auto& b = _neighborBonds[i];
-                auto sa = _adjustedStructureTypes[b.a];
-                auto sb = _adjustedStructureTypes[b.b];
+        const bool wide = N > std::numeric_limits<uint32_t>::max();
+        if(wide){
+            _wideBondsByClass.resize(N);
+        }else{
+            _bondsByClass.resize(N);
+        }
+        buckets.scatter([this](size_t i){ return (size_t) _bondClasses[i]; }, [&](size_t i, size_t slot){
+            if(wide){
+                _wideBondsByClass[slot] = i;
+            }else{
+                _bondsByClass[slot] = (uint32_t) i;
+            }
+        });
+    }
 
-                if(sa == StructureType::OTHER || sb == StructureType::OTHER){
-                    b.disorientation = std::numeric_limits<double>::infinity();
-                    continue;
+    std::pair<size_t, size_t> bondClassRange(BondClass bondClass) const{
+        return { _bondClassOffsets[(size_t) bondClass], _bondClassOffsets[(size_t) bondClass + 1] };
+    }
+
+    // Bond table index of entry k of the class partition.
+    size_t bondByClass(size_t k) const{
+        return _wideBondsByClass.empty() ? (size_t) _bondsByClass[k] : _wideBondsByClass[k];
+    }
+
+    // Runs the kernel instance of one symmetry over its bond class, gathering the reduced
+    // orientations of up to BatchSize bonds into structure-of-arrays form at a time.
+    template<CrystalSymmetry Symmetry>
+    void computeSymmetricDisorientations(BondClass bondClass){
+        if(_disorientationMode == DisorientationMode::Approximate){
+            approximateSymmetricDisorientations<Symmetry>(bondClass);
+            return;
+        }
+
+        constexpr size_t BatchSize = 128;
+        const auto [begin, end] = bondClassRange(bondClass);
+
+        tbb::parallel_for(tbb::blocked_range<size_t>(begin, end, 1024), [&](const tbb::blocked_range<size_t>& r){
+            double ax[BatchSize], ay[BatchSize], az[BatchSize], aw[BatchSize];
+            double bx[BatchSize], by[BatchSize], bz[BatchSize], bw[BatchSize];
+            float results[BatchSize];
+
+            for(size_t first = r.begin(); first < r.end(); first += BatchSize){
+                const size_t count = std::min(BatchSize, r.end() - first);
+                for(size_t k = 0; k < count; ++k){
+                    const size_t bond = bondByClass(first + k);
+                    const PackedQuaternion<Real>& qa = _reducedOrientations[_neighborBonds.a[bond]];
+                    const PackedQuaternion<Real>& qb = _reducedOrientations[_neighborBonds.b[bond]];
+                    ax[k] = qa.x; ay[k] = qa.y; az[k] = qa.z; aw[k] = qa.w;
+                    bx[k] = qb.x; by[k] = qb.y; bz[k] = qb.z; bw[k] = qb.w;
                 }
 
-                if(sa == sb){
-                    b.disorientation = PTM::calculateDisorientation(sa, sb, _adjustedOrientations[b.a], _adjustedOrientations[b.b]);
-                }else if(_handleBoundaries){
-                    Quaternion dummy;
-                    auto tmp = b;
-                    if(interface_cubic_hex(tmp, iface, dummy)){
-                        b.disorientation = tmp.disorientation;
-                    }else{
-                        b.disorientation = std::numeric_limits<double>::infinity();
+                computeDisorientations<Symmetry>({ ax, ay, az, aw }, { bx, by, bz, bw }, count, results);
+
+                for(size_t k = 0; k < count; ++k){
+                    _neighborBonds.disorientation[bondByClass(first + k)] = results[k];
+                }
+            }
+        }, tbb::auto_partitioner{});
+    }
+
+    // Approximate counterpart on the quantized orientations. Bonds outside the identity
+    // region or within _approximateToleranceDeg of the threshold are evaluated exactly by
+    // PTM, so the set of bonds that pass the threshold matches the exact mode.
+    template<CrystalSymmetry Symmetry>
+    void approximateSymmetricDisorientations(BondClass bondClass){
+        constexpr size_t BatchSize = 128;
+        const auto [begin, end] = bondClassRange(bondClass);
+
+        tbb::parallel_for(tbb::blocked_range<size_t>(begin, end, 1024), [&](const tbb::blocked_range<size_t>& r){
+            QuantizedQuaternion qa[BatchSize], qb[BatchSize];
+            float results[BatchSize];
+            size_t fallbacks = 0;
+
+            for(size_t first = r.begin(); first < r.end(); first += BatchSize){
+                const size_t count = std::min(BatchSize, r.end() - first);
+                for(size_t k = 0; k < count; ++k){
+                    const size_t bond = bondByClass(first + k);
+                    qa[k] = _quantizedOrientations[_neighborBonds.a[bond]];
+                    qb[k] = _quantizedOrientations[_neighborBonds.b[bond]];
+                }
+
+                approximateDisorientations<Symmetry>(qa, qb, count, results);
+
+                for(size_t k = 0; k < count; ++k){
+                    const size_t bond = bondByClass(first + k);
+                    float disorientation = results[k];
+                    if(disorientation < 0.0f || std::abs(disorientation - _misorientationThresholdDeg) <= _approximateToleranceDeg){
+                        const Index a = _neighborBonds.a[bond];
+                        const Index b = _neighborBonds.b[bond];
+                        disorientation = (float) PTM::calculateDisorientation(
+                            _adjustedStructureTypes[a], _adjustedStructureTypes[b], _adjustedOrientations[a].quaternion(), _adjustedOrientations[b].quaternion());
+                        fallbacks++;
                     }
-                }else{
-                    b.disorientation = std::numeric_limits<double>::infinity();
+                    _neighborBonds.disorientation[bond] = disorientation;
                 }
             }
+
+            _exactFallbacks.fetch_add(fallbacks, std::memory_order_relaxed);
+            _approximatedBonds.fetch_add(r.size() - fallbacks, std::memory_order_relaxed);
         }, tbb::auto_partitioner{});
+    }
+
+    void computeDisorientationAngles(){
+        if(_neighborBonds.empty()) createNeighborBonds();
+
+        const InterfaceHandler& iface = *_interfaceHandler;
+        const bool interfaces = _handleBoundaries && iface.has_mixed_phases();
+
+        partitionBondsByClass(interfaces);
+        reduceOrientationsToFundamentalZone();
+
+        computeSymmetricDisorientations<CrystalSymmetry::Cubic>(BondClass::Cubic);
+        computeSymmetricDisorientations<CrystalSymmetry::Hexagonal>(BondClass::Hexagonal);
+
+        _reducedOrientations = std::vector<PackedQuaternion<Real>>();
+        _quantizedOrientations = std::vector<QuantizedQuaternion>();
+
+        const auto [otherBegin, otherEnd] = bondClassRange(BondClass::OtherCrystalline);
+        tbb::parallel_for(tbb::blocked_range<size_t>(otherBegin, otherEnd, 1024), [&](const tbb::blocked_range<size_t>& r){
+            for(size_t k = r.begin(); k != r.end(); ++k){
+                const size_t i = bondByClass(k);
+                const Index a = _neighborBonds.a[i];
+                const Index b = _neighborBonds.b[i];
+                _neighborBonds.disorientation[i] = (float) PTM::calculateDisorientation(
+                    _adjustedStructureTypes[a], _adjustedStructureTypes[b], _adjustedOrientations[a].quaternion(), _adjustedOrientations[b].quaternion());
+            }
+        }, tbb::auto_partitioner{});
+
+        const auto [interfaceBegin, interfaceEnd] = bondClassRange(BondClass::Interface);
+        tbb::parallel_for(tbb::blocked_range<size_t>(interfaceBegin, interfaceEnd, 1024), [&](const tbb::blocked_range<size_t>& r){
+            for(size_t k = r.begin(); k != r.end(); ++k){
+                const size_t i = bondByClass(k);
+                Quaternion dummy;
+                NeighborBond tmp{ _neighborBonds.a[i], _neighborBonds.b[i], 0.0 };
+                _neighborBonds.disorientation[i] = cachedInterface(tmp, iface, dummy, i)
+                    ? (float) tmp.disorientation
+                    : std::numeric_limits<float>::infinity();
+            }
+        }, tbb::auto_partitioner{});
+
+        releaseInterfaceCache();
+        _bondsByClass = std::vector<uint32_t>();
+        _wideBondsByClass = std::vector<size_t>();
+
+        std::vector<PackedBond> candidates = packMergeCandidates();
+        _bondClasses = std::vector<BondClass>();
+        sortBondsByDisorientation(candidates);
 
-        tbb::parallel_sort(_neighborBonds.begin(), _neighborBonds.end(), [](const NeighborBond& x, const NeighborBond& y){
-            return x.disorientation < y.disorientation;
+        // Sorting breaks the per-atom grouping of the bond table.
+        _bondOffsets.clear();
+    }
+
+    bool isMergeCandidate(size_t i) const{
+        return _bondClasses[i] != BondClass::NonCrystalline
+            && _neighborBonds.disorientation[i] < _misorientationThresholdDeg;
+    }
+
+    // Packs the bonds that can become graph edges (crystalline and below the misorientation
+    // threshold) for sortBondsByDisorientation and drops the rest, so the sort and the graph
+    // only see useful bonds. Reuses the bond classes of partitionBondsByClass and keeps the
+    // bond order. Runs as a blocked parallel count/scan/scatter.
+    std::vector<PackedBond> packMergeCandidates() const{
+        auto candidate = [this](size_t i){
+            return isMergeCandidate(i) ? size_t(0) : size_t(1);
+        };
+        BlockedBuckets<2> buckets(_neighborBonds.size(), 16384);
+        buckets.count(candidate);
+
+        std::vector<PackedBond> packed(buckets.bucketOffset(1));
+        buckets.scatter(candidate, [&](size_t i, size_t slot){
+            packed[slot] = { _neighborBonds.disorientation[i], _neighborBonds.a[i], _neighborBonds.b[i] };
+        }, 1);
+        return packed;
+    }
+
+    // Sorts the merge candidates by disorientation into the bond arrays and evaluates the
+    // graph weights exp(-theta^2 / 3) in the same pass, so determineMergeSequence gets
+    // ready (a, b, weight) triples. Equal disorientations keep the (a, b) order of the
+    // bond table, so the result does not depend on thread scheduling.
+    void sortBondsByDisorientation(std::vector<PackedBond>& packed){
+        radixSortByDisorientation(packed);
+
+        const size_t N = packed.size();
+        _neighborBonds = NeighborBondArray();
+        _neighborBonds.resize(N);
+        _neighborBonds.weight.resize(N);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, N, 4096), [&](const tbb::blocked_range<size_t>& r){
+            for(size_t i = r.begin(); i != r.end(); ++i){
+                _neighborBonds.disorientation[i] = packed[i].disorientation;
+                _neighborBonds.a[i] = packed[i].a;
+                _neighborBonds.b[i] = packed[i].b;
+            }
+            computeGraphWeights(&_neighborBonds.disorientation[r.begin()], r.size(), &_neighborBonds.weight[r.begin()]);
         });
     }
 
@@ -856,35 +2325,40 @@ private:
         return disorientation;
     }
 
-    void node_pair_sampling_clustering(Graph& graph, std::vector<Quaternion>& qsum){
+    // Runs the nearest-neighbor chain on one component graph. Graph node k stands for atom
+    // atoms[k]; the merges are appended to dendrogram with atom indices.
+    void node_pair_sampling_clustering(Graph& graph, const Index* atoms, std::vector<PackedQuaternion<Real>>& qsum, std::vector<DendrogramNode>& dendrogram){
         double totalWeight = 1;
 
-        size_t progressVal = 0;
-        std::vector<size_t> chain;
+        std::vector<Index> chain;
         while(graph.num_nodes()){
             // nearest-neighbor chain
-            size_t node = graph.next_node();
+            Index node = graph.next_node();
 
             chain.push_back(node);
             while(!chain.empty()){
 
-                size_t a = chain.back();
+                Index a = chain.back();
                 chain.pop_back();
 
                 auto [d, b] = graph.nearestNeighbor(a);
-                if(b == std::numeric_limits<size_t>::max()){
+                if(b == InvalidIndex){
                     // Remove the connected component
                     graph.remove_node(a);
                 }else if(!chain.empty()){
-                    size_t c = chain.back();
+                    Index c = chain.back();
                     chain.pop_back();
 
                     if(b == c){
-                        size_t parent = graph.contract_edge(a, b);
-                        size_t child = (parent == a) ? b : a;
-
-                        double disorientation = calculate_disorientation(_adjustedStructureTypes[parent], qsum[parent], qsum[child]);
-                        _dendrogram.emplace_back(parent, child, d / totalWeight, disorientation, 1, qsum[parent]);
+                        Index parent = graph.contract_edge(a, b);
+                        Index child = (parent == a) ? b : a;
+                        parent = atoms[parent];
+                        child = atoms[child];
+
+                        Quaternion merged = qsum[parent].quaternion();
+                        double disorientation = calculate_disorientation(_adjustedStructureTypes[parent], merged, qsum[child].quaternion());
+                        qsum[parent] = merged;
+                        dendrogram.emplace_back(parent, child, d / totalWeight, disorientation, 1, merged);
                     }else{
                         chain.push_back(c);
                         chain.push_back(a);
@@ -898,26 +2372,485 @@ private:
         }
     }
 
-    void determineMergeSequence(){
-        Graph graph(_numParticles, _neighborBonds.size());
-        size_t counter = 0;
-        for(auto edge : _neighborBonds){
-            if(isCrystallineBond(edge) && edge.disorientation < _misorientationThresholdDeg){
-                double weight = calculateGraphWeight(edge.disorientation);
-                graph.add_edge(edge.a, edge.b, weight);
+    // Connected components of the bond graph. Component c owns the atoms
+    // [atomOffsets[c], atomOffsets[c + 1]) of atoms, in increasing index order, and the
+    // bonds [bondOffsets[c], bondOffsets[c + 1]) of bonds, in sorted bond order.
+    struct BondGraphComponents{
+        std::vector<size_t> atomOffsets;
+        std::vector<Index> atoms;
+        std::vector<size_t> bondOffsets;
+        std::vector<size_t> bonds;
+
+        size_t size() const{
+            return atomOffsets.empty() ? 0 : atomOffsets.size() - 1;
+        }
+
+        size_t numAtoms(size_t c) const{
+            return atomOffsets[c + 1] - atomOffsets[c];
+        }
+    };
+
+    // Lock-free union-find over the bonds in parallel. The larger root is always linked
+    // under the smaller one, so every component ends up rooted at its lowest atom no
+    // matter how the unions interleave.
+    BondGraphComponents findBondGraphComponents() const{
+        std::vector<std::atomic<Index>> parents(_numParticles);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, _numParticles, 4096), [&](const tbb::blocked_range<size_t>& r){
+            for(size_t i = r.begin(); i != r.end(); ++i){
+                parents[i].store((Index) i, std::memory_order_relaxed);
+            }
+        });
+
+        auto find = [&](Index x){
+            Index parent = parents[x].load(std::memory_order_relaxed);
+            while(parent != x){
+                const Index grandparent = parents[parent].load(std::memory_order_relaxed);
+                parents[x].compare_exchange_weak(parent, grandparent, std::memory_order_relaxed);
+                x = parent;
+                parent = parents[x].load(std::memory_order_relaxed);
+            }
+            return x;
+        };
+
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, _neighborBonds.size(), 4096), [&](const tbb::blocked_range<size_t>& r){
+            for(size_t i = r.begin(); i != r.end(); ++i){
+                Index ra = find(_neighborBonds.a[i]);
+                Index rb = find(_neighborBonds.b[i]);
+                while(ra != rb){
+                    if(ra < rb) std::swap(ra, rb);
+                    Index expected = ra;
+                    if(parents[ra].compare_exchange_strong(expected, rb, std::memory_order_relaxed)) break;
+                    ra = find(ra);
+                    rb = find(rb);
+                }
+            }
+        });
+
+        std::vector<Index> roots(_numParticles);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, _numParticles, 4096), [&](const tbb::blocked_range<size_t>& r){
+            for(size_t i = r.begin(); i != r.end(); ++i){
+                roots[i] = find((Index) i);
+            }
+        });
+
+        // The root of a component with two or more atoms is its lowest atom, so it is the
+        // a of one of its bonds. Atoms without bonds are their own root and alone.
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, _numParticles, 4096), [&](const tbb::blocked_range<size_t>& r){
+            for(size_t i = r.begin(); i != r.end(); ++i){
+                parents[i].store(0, std::memory_order_relaxed);
+            }
+        });
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, _neighborBonds.size(), 4096), [&](const tbb::blocked_range<size_t>& r){
+            for(size_t i = r.begin(); i != r.end(); ++i){
+                parents[_neighborBonds.a[i]].store(1, std::memory_order_relaxed);
+            }
+        });
+
+        // Components are numbered in the order of their roots.
+        std::vector<Index> componentOf(_numParticles);
+        const size_t numComponents = tbb::parallel_scan(tbb::blocked_range<size_t>(0, _numParticles, 4096), size_t(0),
+            [&](const tbb::blocked_range<size_t>& r, size_t sum, bool isFinalScan){
+                for(size_t i = r.begin(); i != r.end(); ++i){
+                    const bool isRoot = roots[i] == i && parents[i].load(std::memory_order_relaxed) != 0;
+                    if(isFinalScan){
+                        componentOf[i] = isRoot ? (Index) sum : InvalidIndex;
+                    }
+                    sum += isRoot;
+                }
+                return sum;
+            },
+            std::plus<size_t>()
+        );
+        parents = std::vector<std::atomic<Index>>();
+
+        // Offsets of the runs of each component in keys sorted by component.
+        auto runOffsets = [numComponents](const std::vector<Index>& sortedKeys){
+            const size_t n = sortedKeys.size();
+            std::vector<size_t> offsets(numComponents + 1, n);
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, n, 4096), [&](const tbb::blocked_range<size_t>& r){
+                for(size_t p = r.begin(); p != r.end(); ++p){
+                    const size_t first = (p == 0) ? 0 : (size_t) sortedKeys[p - 1] + 1;
+                    for(size_t c = first; c <= sortedKeys[p]; ++c){
+                        offsets[c] = p;
+                    }
+                }
+            });
+            return offsets;
+        };
+
+        // Atoms and bonds are bucketed by component with a stable radix sort, so every
+        // component lists them in increasing index order. Atoms without bonds get the
+        // key numComponents and are cut off behind the last component.
+        const Index noComponent = (Index) numComponents;
+        BondGraphComponents components;
+        std::vector<Index> keys(_numParticles);
+        components.atoms.resize(_numParticles);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, _numParticles, 4096), [&](const tbb::blocked_range<size_t>& r){
+            for(size_t i = r.begin(); i != r.end(); ++i){
+                const Index c = componentOf[roots[i]];
+                keys[i] = (c == InvalidIndex) ? noComponent : c;
+                components.atoms[i] = (Index) i;
             }
+        });
+        radixSortByKey(keys, components.atoms, noComponent);
+        components.atomOffsets = runOffsets(keys);
+        components.atoms.resize(components.atomOffsets.back());
+
+        const size_t numBonds = _neighborBonds.size();
+        keys.resize(numBonds);
+        components.bonds.resize(numBonds);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, numBonds, 4096), [&](const tbb::blocked_range<size_t>& r){
+            for(size_t i = r.begin(); i != r.end(); ++i){
+                keys[i] = componentOf[roots[_neighborBonds.a[i]]];
+                components.bonds[i] = i;
+            }
+        });
+        radixSortByKey(keys, components.bonds, noComponent);
+        components.bondOffsets = runOffsets(keys);
+
+        return components;
+    }
+
+    // Builds the graph of one component with local node indices and clusters it. Local
+    // indices follow the atom order, so ties break exactly as on the full graph.
+    void clusterComponent(const BondGraphComponents& components, size_t c, std::vector<Index>& localIndex, std::vector<PackedQuaternion<Real>>& qsum, std::vector<DendrogramNode>& dendrogram){
+        const Index* atoms = &components.atoms[components.atomOffsets[c]];
+        const size_t numAtoms = components.numAtoms(c);
+        for(size_t k = 0; k < numAtoms; ++k){
+            localIndex[atoms[k]] = (Index) k;
+        }
+
+        const size_t firstBond = components.bondOffsets[c];
+        const size_t lastBond = components.bondOffsets[c + 1];
+        Graph graph(numAtoms, lastBond - firstBond);
+
+        // Only crystalline bonds below the threshold survive computeDisorientationAngles,
+        // each with its edge weight.
+        for(size_t k = firstBond; k < lastBond; ++k){
+            const size_t i = components.bonds[k];
+            graph.add_edge(localIndex[_neighborBonds.a[i]], localIndex[_neighborBonds.b[i]], _neighborBonds.weight[i]);
+        }
+
+        dendrogram.reserve(numAtoms - 1);
+        node_pair_sampling_clustering(graph, atoms, qsum, dendrogram);
+        _nearestNeighborHits.fetch_add(graph.nearestCache.hits(), std::memory_order_relaxed);
+        _nearestNeighborRescans.fetch_add(graph.nearestCache.rescans(), std::memory_order_relaxed);
+    }
+
+    // Nearest-neighbor chains on the connected components of the bond graph.
+    void chain_clustering(std::vector<PackedQuaternion<Real>>& qsum){
+        const BondGraphComponents components = findBondGraphComponents();
+        const size_t numComponents = components.size();
+
+        // Components are independent, so each runs its own chain as a task. The largest
+        // start first to keep the long chains off the tail of the schedule.
+        std::vector<size_t> order(numComponents);
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::stable_sort(order.begin(), order.end(), [&](size_t x, size_t y){
+            return components.numAtoms(x) > components.numAtoms(y);
+        });
+
+        std::vector<Index> localIndex(_numParticles);
+        std::vector<std::vector<DendrogramNode>> dendrograms(numComponents);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, numComponents, 1), [&](const tbb::blocked_range<size_t>& r){
+            for(size_t k = r.begin(); k != r.end(); ++k){
+                const size_t c = order[k];
+                clusterComponent(components, c, localIndex, qsum, dendrograms[c]);
+            }
+        }, tbb::simple_partitioner{});
+
+        _dendrogram.reserve(components.atoms.size() - numComponents);
+        for(std::vector<DendrogramNode>& dendrogram : dendrograms){
+            _dendrogram.insert(_dendrogram.end(), dendrogram.begin(), dendrogram.end());
+            dendrogram = std::vector<DendrogramNode>();
+        }
+    }
+
+    // Adjacency of the active clusters in compressed sparse row form. Row k belongs to
+    // nodes[k] and holds sizes[k] entries from offsets[k], sorted by neighbor. Rows need
+    // not be contiguous: the arrays may also hold stale rows of earlier rounds.
+    struct ClusterAdjacency{
+        std::vector<Index> nodes;
+        std::vector<size_t> offsets;
+        std::vector<Index> sizes;
+        std::vector<Index> neighbors;
+        std::vector<double> weights;
+    };
+
+    // Round-based reciprocal nearest-neighbor clustering. Each round finds the nearest
+    // neighbor of every active cluster in parallel, merges all mutually nearest pairs at
+    // once and rebuilds the rows of the merged clusters and their neighbors.
+    // Node-pair-sampling linkage is reducible, so the merges are those of the chain up to
+    // ties and rounding.
+    void reciprocal_clustering(std::vector<PackedQuaternion<Real>>& qsum){
+        const size_t numBonds = _neighborBonds.size();
+        std::vector<double> wnode(_numParticles, 0.0);
+        std::vector<Index> degree(_numParticles, 0);
+        for(size_t i = 0; i < numBonds; ++i){
+            const double w = _neighborBonds.weight[i];
+            wnode[_neighborBonds.a[i]] += w;
+            wnode[_neighborBonds.b[i]] += w;
+            degree[_neighborBonds.a[i]]++;
+            degree[_neighborBonds.b[i]]++;
+        }
+
+        ClusterAdjacency graph;
+        std::vector<Index> rowOf(_numParticles, InvalidIndex);
+        for(size_t i = 0; i < _numParticles; ++i){
+            if(degree[i] == 0) continue;
+            rowOf[i] = (Index) graph.nodes.size();
+            graph.nodes.push_back((Index) i);
+            graph.offsets.push_back(graph.neighbors.size());
+            graph.sizes.push_back(0);
+            graph.neighbors.resize(graph.neighbors.size() + degree[i]);
+        }
+        degree = std::vector<Index>();
+        graph.weights.resize(graph.neighbors.size());
+
+        // Bonds are visited in sorted order, so the rows still have to be sorted by neighbor.
+        for(size_t i = 0; i < numBonds; ++i){
+            const Index a = _neighborBonds.a[i];
+            const Index b = _neighborBonds.b[i];
+            const double w = _neighborBonds.weight[i];
+            const Index ra = rowOf[a];
+            const Index rb = rowOf[b];
+            graph.neighbors[graph.offsets[ra] + graph.sizes[ra]] = b;
+            graph.weights[graph.offsets[ra] + graph.sizes[ra]++] = w;
+            graph.neighbors[graph.offsets[rb] + graph.sizes[rb]] = a;
+            graph.weights[graph.offsets[rb] + graph.sizes[rb]++] = w;
+        }
+
+        std::vector<Index> representative(_numParticles);
+        std::iota(representative.begin(), representative.end(), (Index) 0);
+
+        tbb::enumerable_thread_specific<std::vector<std::pair<Index, double>>> scratch;
+        rebuildClusterAdjacency(graph, graph.nodes, true, rowOf, representative, scratch);
+
+        std::vector<Index> nearest;
+        std::vector<double> distances;
+        std::vector<std::tuple<Index, Index, double>> pairs;
+        std::vector<Index> survivors;
+        while(!graph.nodes.empty()){
+            const size_t numNodes = graph.nodes.size();
+            nearest.resize(numNodes);
+            distances.resize(numNodes);
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, numNodes, 1024), [&](const tbb::blocked_range<size_t>& r){
+                for(size_t k = r.begin(); k != r.end(); ++k){
+                    double dmin = std::numeric_limits<double>::infinity();
+                    Index vmin = InvalidIndex;
+                    const size_t first = graph.offsets[k];
+                    for(size_t e = first; e < first + graph.sizes[k]; ++e){
+                        const Index v = graph.neighbors[e];
+                        const double d = wnode[v] / std::max(graph.weights[e], 1e-300);
+                        if(d < dmin || (d == dmin && v < vmin)){
+                            dmin = d; vmin = v;
+                        }
+                    }
+                    nearest[k] = vmin;
+                    distances[k] = dmin * wnode[graph.nodes[k]];
+                }
+            });
+
+            // Mutually nearest pairs, each listed once by its smaller node, in node order.
+            auto reciprocal = [&](size_t k){
+                const Index u = graph.nodes[k];
+                const Index v = nearest[k];
+                return (v != InvalidIndex && u < v && nearest[rowOf[v]] == u) ? size_t(0) : size_t(1);
+            };
+            BlockedBuckets<2> pairBuckets(numNodes, 16384);
+            pairBuckets.count(reciprocal);
+            pairs.resize(pairBuckets.bucketOffset(1));
+            pairBuckets.scatter(reciprocal, [&](size_t k, size_t slot){
+                pairs[slot] = { graph.nodes[k], nearest[k], distances[k] };
+            }, 1);
+
+            // Rounding can break the symmetry of the distances; the closest pair always
+            // merges, so every round makes progress.
+            if(pairs.empty()){
+                size_t best = numNodes;
+                for(size_t k = 0; k < numNodes; ++k){
+                    if(nearest[k] != InvalidIndex && (best == numNodes || distances[k] < distances[best])){
+                        best = k;
+                    }
+                }
+                if(best != numNodes){
+                    pairs.emplace_back(std::min(graph.nodes[best], nearest[best]), std::max(graph.nodes[best], nearest[best]), distances[best]);
+                }
+            }
+
+            const size_t firstNode = _dendrogram.size();
+            _dendrogram.resize(firstNode + pairs.size());
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, pairs.size(), 256), [&](const tbb::blocked_range<size_t>& r){
+                for(size_t k = r.begin(); k != r.end(); ++k){
+                    auto [parent, child, d] = pairs[k];
+                    if(graph.sizes[rowOf[child]] > graph.sizes[rowOf[parent]]){
+                        std::swap(parent, child);
+                    }
+                    representative[child] = parent;
+                    wnode[parent] += wnode[child];
+
+                    Quaternion merged = qsum[parent].quaternion();
+                    double disorientation = calculate_disorientation(_adjustedStructureTypes[parent], merged, qsum[child].quaternion());
+                    qsum[parent] = merged;
+                    _dendrogram[firstNode + k] = DendrogramNode(parent, child, d, disorientation, 1, merged);
+                }
+            });
+
+            // Merged-away clusters and clusters without neighbors leave the graph.
+            auto survives = [&](size_t k){
+                const Index u = graph.nodes[k];
+                return (nearest[k] != InvalidIndex && representative[u] == u) ? size_t(0) : size_t(1);
+            };
+            BlockedBuckets<2> survivorBuckets(numNodes, 16384);
+            survivorBuckets.count(survives);
+            survivors.resize(survivorBuckets.bucketOffset(1));
+            survivorBuckets.scatter(survives, [&](size_t k, size_t slot){
+                survivors[slot] = graph.nodes[k];
+            }, 1);
+            rebuildClusterAdjacency(graph, survivors, false, rowOf, representative, scratch);
+        }
+    }
+
+    // Replaces graph by the adjacency of the surviving clusters. Only the rows of merged
+    // clusters and of the neighbors of absorbed clusters change: such a row joins the rows
+    // of its merged clusters, relabels neighbors to their representatives, drops the merged
+    // edge and sums the weights of parallel edges. The other rows keep their entries. Rebuilt
+    // rows are appended while stale rows stay below half of the arrays; otherwise all rows
+    // are laid out afresh, copying the unchanged ones. Rows are rebuilt independently in
+    // parallel; summing in (neighbor, weight) order keeps the result deterministic.
+    void rebuildClusterAdjacency(
+        ClusterAdjacency& graph,
+        const std::vector<Index>& survivors,
+        bool everyRow,
+        std::vector<Index>& rowOf,
+        const std::vector<Index>& representative,
+        tbb::enumerable_thread_specific<std::vector<std::pair<Index, double>>>& scratch
+    ){
+        const size_t numNodes = survivors.size();
+
+        // A survivor absorbed at most one cluster this round, found through the old rows.
+        std::vector<Index> absorbedByRow(graph.nodes.size(), InvalidIndex);
+        std::vector<uint8_t> changedByRow(graph.nodes.size(), everyRow ? 1 : 0);
+        for(Index u : graph.nodes){
+            const Index parent = representative[u];
+            if(parent == u) continue;
+            const size_t row = rowOf[u];
+            absorbedByRow[rowOf[parent]] = u;
+            changedByRow[rowOf[parent]] = 1;
+            for(size_t e = graph.offsets[row]; e < graph.offsets[row] + graph.sizes[row]; ++e){
+                changedByRow[rowOf[representative[graph.neighbors[e]]]] = 1;
+            }
+        }
+
+        // A rebuilt row needs room for the entries of both merged clusters.
+        std::vector<Index> absorbed(numNodes);
+        std::vector<int> capacities(numNodes);
+        size_t kept = 0;
+        size_t rebuilt = 0;
+        for(size_t k = 0; k < numNodes; ++k){
+            const Index row = rowOf[survivors[k]];
+            absorbed[k] = absorbedByRow[row];
+            capacities[k] = (int) graph.sizes[row];
+            if(!changedByRow[row]){
+                kept += graph.sizes[row];
+                continue;
+            }
+            if(absorbed[k] != InvalidIndex) capacities[k] += (int) graph.sizes[rowOf[absorbed[k]]];
+            rebuilt += capacities[k];
+        }
+
+        const bool append = graph.neighbors.size() + rebuilt <= 2 * (kept + rebuilt);
+        if(append){
+            for(size_t k = 0; k < numNodes; ++k){
+                if(!changedByRow[rowOf[survivors[k]]]) capacities[k] = 0;
+            }
+        }
+        std::vector<size_t> placement;
+        exclusiveScan(capacities, placement);
+
+        const size_t base = append ? graph.neighbors.size() : 0;
+        std::vector<Index> freshNeighbors;
+        std::vector<double> freshWeights;
+        if(append){
+            graph.neighbors.resize(base + placement[numNodes]);
+            graph.weights.resize(base + placement[numNodes]);
+        }else{
+            freshNeighbors.resize(placement[numNodes]);
+            freshWeights.resize(placement[numNodes]);
         }
+        std::vector<Index>& neighbors = append ? graph.neighbors : freshNeighbors;
+        std::vector<double>& weights = append ? graph.weights : freshWeights;
+
+        std::vector<size_t> offsets(numNodes);
+        std::vector<Index> sizes(numNodes);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, numNodes, 256), [&](const tbb::blocked_range<size_t>& r){
+            std::vector<std::pair<Index, double>>& entries = scratch.local();
+            for(size_t k = r.begin(); k != r.end(); ++k){
+                const Index u = survivors[k];
+                const size_t first = base + placement[k];
+                const size_t oldRow = rowOf[u];
+                if(!changedByRow[oldRow]){
+                    sizes[k] = graph.sizes[oldRow];
+                    offsets[k] = append ? graph.offsets[oldRow] : first;
+                    if(!append){
+                        std::copy_n(&graph.neighbors[graph.offsets[oldRow]], sizes[k], &neighbors[first]);
+                        std::copy_n(&graph.weights[graph.offsets[oldRow]], sizes[k], &weights[first]);
+                    }
+                    continue;
+                }
+
+                entries.clear();
+                for(Index node : { u, absorbed[k] }){
+                    if(node == InvalidIndex) continue;
+                    const size_t row = rowOf[node];
+                    for(size_t e = graph.offsets[row]; e < graph.offsets[row] + graph.sizes[row]; ++e){
+                        const Index v = representative[graph.neighbors[e]];
+                        if(v != u) entries.emplace_back(v, graph.weights[e]);
+                    }
+                }
+                std::sort(entries.begin(), entries.end());
 
-        std::vector<Quaternion> qsum(_adjustedOrientations.cbegin(), _adjustedOrientations.cend());
-        DisjointSet uf(_numParticles);
+                size_t out = first;
+                for(size_t e = 0; e < entries.size(); ++e){
+                    if(out > first && neighbors[out - 1] == entries[e].first){
+                        weights[out - 1] += entries[e].second;
+                    }else{
+                        neighbors[out] = entries[e].first;
+                        weights[out++] = entries[e].second;
+                    }
+                }
+                offsets[k] = first;
+                sizes[k] = (Index) (out - first);
+            }
+        });
+
+        graph.nodes = survivors;
+        graph.offsets = std::move(offsets);
+        graph.sizes = std::move(sizes);
+        if(!append){
+            graph.neighbors = std::move(freshNeighbors);
+            graph.weights = std::move(freshWeights);
+        }
+        for(size_t k = 0; k < numNodes; ++k){
+            rowOf[graph.nodes[k]] = (Index) k;
+        }
+    }
+
+    void determineMergeSequence(){
+        std::vector<PackedQuaternion<Real>> qsum(_adjustedOrientations.cbegin(), _adjustedOrientations.cend());
         _dendrogram.resize(0);
-        node_pair_sampling_clustering(graph, qsum);
+        if(_clusteringMode == ClusteringMode::Reciprocal){
+            reciprocal_clustering(qsum);
+        }else{
+            chain_clustering(qsum);
+        }
+
+        DisjointSet<Index> uf(_numParticles);
 
         std::sort(_dendrogram.begin(), _dendrogram.end(), [](const DendrogramNode& a, const DendrogramNode& b){ 
             return a.distance < b.distance; 
         });
 
-        size_t numPlot = 0;
         uf.clear();
         for(DendrogramNode& node : _dendrogram){
             size_t sa = uf.nodesize(uf.find(node.a));
@@ -929,57 +2862,25 @@ private:
             uf.merge(node.a, node.b);
 
             node.size = dsize;
-            if(dsize >= _minPlotSize){
-                numPlot++;
-            }
-        }
-
-        // Create PropertyStorage objects for the output plot.
-        std::vector<double> mergeDistanceArray;
-        std::vector<double> mergeSizeArray;
-        
-        mergeDistanceArray.reserve(numPlot);
-        mergeSizeArray.reserve(numPlot);
-
-        // Generate output data plot points from dendrogram data.
-        for(const DendrogramNode& node : _dendrogram){
-            if(node.size >= _minPlotSize){
-                mergeDistanceArray.push_back(std::log(node.distance));
-                mergeSizeArray.push_back(node.size);
-            }
         }
 
         auto regressor = Regressor(_dendrogram);
         _suggestedMergingThreshold = regressor.calculate_threshold(_dendrogram, 1.5);
-
-        // Create PropertyStorage objects for the output plot.
-        numPlot = 0;
-        for(auto y : regressor.ys){
-            // plot positive distances only, for clarity
-            numPlot += (y > 0) ? 1 : 0;
-        }
-
-        std::vector<double> logMergeSizeArray;
-        std::vector<double> logMergeDistanceArray;
-        
-        logMergeSizeArray.reserve(numPlot);
-        logMergeDistanceArray.reserve(numPlot);
-
-        // Generate output data plot points from dendrogram data.
-        for(size_t i = 0; i < regressor.residuals.size(); i++){
-            if(regressor.ys[i] > 0){
-                logMergeSizeArray.push_back(regressor.xs[i]);
-                logMergeDistanceArray.push_back(regressor.ys[i]);
-            }
-        }
     }
 
 private:
     static constexpr double _misorientationThresholdDeg = 4.0;
-    const size_t _minPlotSize = 20;
+    static constexpr double _interfaceBandWidthDeg = 0.25;
+    static constexpr double _approximateToleranceDeg = 0.05;
 
     bool _handleBoundaries;
     size_t _numParticles;
+    NeighborSearchBackend _neighborBackend = NeighborSearchBackend::Tree;
+    size_t _searchedNeighborRows = 0;
+    InterfacePropagation _interfacePropagation = InterfacePropagation::Serial;
+    bool _interfaceCacheEnabled = false;
+    DisorientationMode _disorientationMode = DisorientationMode::Exact;
+    ClusteringMode _clusteringMode = ClusteringMode::Chain;
 
     std::shared_ptr<ParticleProperty> _positions;
     std::shared_ptr<ParticleProperty> _structuresProperty;
@@ -989,14 +2890,44 @@ private:
     const SimulationCell _simCell;
     bool _outputBonds;
 
-    std::vector<NeighborBond> _neighborBonds;
+    NeighborTable _neighbors;
+    std::vector<size_t> _bondOffsets;
+    NeighborBondArray _neighborBonds;
+
+    // Flat interface cache: slot of every bond of the bond table (NoBond for bonds that can
+    // never be interface bonds) and one entry per slot.
+    struct CachedInterface{
+        double disorientation = 0.0;
+        Quaternion rotation;
+        bool isInterface = false;
+        bool computed = false;
+    };
+
+    std::vector<size_t> _interfaceSlots;
+    std::vector<CachedInterface> _interfaceCache;
+    std::atomic<size_t> _interfaceCacheHits{0};
+    std::atomic<size_t> _interfaceCacheMisses{0};
+
+    std::optional<InterfaceHandler> _interfaceHandler;
+    InterfacePass _interfacePass = InterfacePass::Disabled;
     std::vector<StructureType> _adjustedStructureTypes;
-    std::vector<Quaternion> _adjustedOrientations;
+    std::vector<PackedQuaternion<Real>> _adjustedOrientations;
+    std::vector<PackedQuaternion<Real>> _reducedOrientations;
+    std::vector<QuantizedQuaternion> _quantizedOrientations;
+    std::atomic<size_t> _approximatedBonds{0};
+    std::atomic<size_t> _exactFallbacks{0};
+    std::atomic<size_t> _nearestNeighborHits{0};
+    std::atomic<size_t> _nearestNeighborRescans{0};
+    std::vector<BondClass> _bondClasses;
+    std::vector<uint32_t> _bondsByClass;
+    std::vector<size_t> _wideBondsByClass;
+    std::array<size_t, NumBondClasses + 1> _bondClassOffsets{};
 
     std::vector<DendrogramNode> _dendrogram;
     double _suggestedMergingThreshold = 0.0;
 };
 
+template<typename Index, typename Real = double>
 class GrainSegmentationEngine2{
 public:
     struct GrainInfo{
@@ -1006,7 +2937,7 @@ public:
     };
 
     GrainSegmentationEngine2(
-        std::shared_ptr<const GrainSegmentationEngine1> engine1,
+        std::shared_ptr<const GrainSegmentationEngine1<Index, Real>> engine1,
         bool adoptOrphanAtoms,
         size_t minGrainAtomCount,
         bool colorParticlesByGrain
@@ -1026,32 +2957,32 @@ public:
         const auto& dendro = _engine1->dendrogram();
         double thr = _engine1->suggestedMergingThreshold();
 
-        DisjointSet uf(_numParticles);
-        std::vector<Quaternion> meanQ(_engine1->orientationsProperty()->size());
-        const double* qptr = _engine1->orientationsProperty()->dataDouble();
+        DisjointSet<Index> uf(_numParticles);
+        const ParticleProperty& orientations = *_engine1->orientationsProperty();
+        std::vector<PackedQuaternion<Real>> meanQ(orientations.size());
 
         for(size_t i = 0; i < _numParticles; ++i){
-            meanQ[i] = Quaternion(qptr[4 * i + 0], qptr[4 * i + 1], qptr[4 * i + 2], qptr[4 * i + 3]);
+            meanQ[i] = propertyOrientation(orientations, i);
         }
 
         for(const auto& node : dendro){
             double logD = std::log(node.distance);
             if(logD > thr) break;
             uf.merge(node.a, node.b);
-            size_t p = uf.find(node.a);
+            Index p = uf.find(node.a);
             meanQ[p] = node.orientation;
         }
 
-        std::vector<size_t> rep2id(_numParticles, 0);
-        size_t nextId = 1;
-        for(size_t i = 0; i < _numParticles; ++i){
+        std::vector<Index> rep2id(_numParticles, 0);
+        Index nextId = 1;
+        for(Index i = 0; i < _numParticles; ++i){
             if(uf.find(i) == i){
                 rep2id[i] = (uf.nodesize(i) >= _minGrainAtomCount) ? nextId++ : 0;
             }
         }
 
-        for(size_t i = 0; i < _numParticles; ++i){
-            size_t rep = uf.find(i);
+        for(Index i = 0; i < _numParticles; ++i){
+            Index rep = uf.find(i);
             _atomClusters->setInt(i, (int) rep2id[rep]);
         }
 
@@ -1059,11 +2990,11 @@ public:
         _grains.clear();
         _grains.reserve(_grainCount);
 
-        for(size_t rep = 0; rep < _numParticles; ++rep){
+        for(Index rep = 0; rep < _numParticles; ++rep){
             if(uf.find(rep) == rep){
                 int gid = (int) rep2id[rep];
                 if(gid > 0){
-                    Quaternion q = meanQ[rep].normalized();
+                    Quaternion q = meanQ[rep].quaternion().normalized();
                     _grains.emplace_back(GrainInfo{gid, uf.nodesize(rep), q});
                 }
             }
@@ -1083,7 +3014,7 @@ public:
     }
 
 private:
-    std::shared_ptr<const GrainSegmentationEngine1> _engine1;
+    std::shared_ptr<const GrainSegmentationEngine1<Index, Real>> _engine1;
     size_t _numParticles = 0;
 
     bool _adoptOrphanAtoms = false;
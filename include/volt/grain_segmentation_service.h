@@ -27,6 +27,14 @@ public:
         bool outputBonds
     );
 
+    void setSpatialReordering(bool enabled);
+    void setNeighborBackend(NeighborSearchBackend backend);
+    void setInterfacePropagation(InterfacePropagation propagation);
+    void setInterfaceCache(bool enabled);
+    void setOrientationPrecision(OrientationPrecision precision);
+    void setDisorientationMode(DisorientationMode mode);
+    void setClusteringMode(ClusteringMode mode);
+
     json compute(
         const LammpsParser::Frame &frame,
         const std::string &outputFilename = ""
@@ -39,13 +47,30 @@ private:
     int _minGrainAtomCount;
     bool _handleCoherentInterfaces;
     bool _outputBonds;
+    bool _spatialReordering;
+    NeighborSearchBackend _neighborBackend;
+    InterfacePropagation _interfacePropagation;
+    bool _interfaceCache;
+    OrientationPrecision _orientationPrecision;
+    DisorientationMode _disorientationMode;
+    ClusteringMode _clusteringMode;
 
     json performGrainSegmentation(
         const LammpsParser::Frame &frame,
+        const std::vector<size_t>& order,
         const std::vector<int>& structureTypes,
         const std::vector<PtmLocalAtomState>& ptmStates,
         const std::string& outputFile
     );
+
+    template<typename Index, typename Real>
+    json segmentGrains(
+        const LammpsParser::Frame &frame,
+        const std::vector<size_t>& order,
+        const std::vector<int>& analyzedStructureTypes,
+        const std::vector<PtmLocalAtomState>& ptmStates,
+        const std::string& outputFile
+    );
 };
 
 }
@@ -0,0 +1,124 @@
+#include <volt/cell_list_neighbor_finder.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+namespace Volt{
+
+namespace{
+
+Vector3 cross(const Vector3& a, const Vector3& b){
+    return Vector3(
+        a.y() * b.z() - a.z() * b.y(),
+        a.z() * b.x() - a.x() * b.z(),
+        a.x() * b.y() - a.y() * b.x()
+    );
+}
+
+double dot(const Vector3& a, const Vector3& b){
+    return a.x() * b.x() + a.y() * b.y() + a.z() * b.z();
+}
+
+}
+
+bool CellListNeighborFinder::prepare(const Point3* positions, size_t count, const SimulationCell& cell, int neighborsPerAtom){
+    for(int dim = 0; dim < 3; dim++){
+        _cellVectors[dim] = cell.cellVector(dim);
+        _pbc[dim] = cell.hasPbc(dim);
+    }
+
+    const Vector3& a = _cellVectors[0];
+    const Vector3& b = _cellVectors[1];
+    const Vector3& c = _cellVectors[2];
+    const Vector3 faceNormals[3] = { cross(b, c), cross(c, a), cross(a, b) };
+    const double volume = std::abs(dot(a, faceNormals[0]));
+    if(count == 0 || !(volume > 0.0)){
+        return false;
+    }
+
+    _orthogonal = a.y() == 0 && a.z() == 0 && b.x() == 0 && b.z() == 0 && c.x() == 0 && c.y() == 0;
+    _boxLengths[0] = a.x();
+    _boxLengths[1] = b.y();
+    _boxLengths[2] = c.z();
+
+    // Bins are sized so that the first ring around an atom holds about 1.5 times the
+    // requested number of neighbors at the average density.
+    const double density = double(count) / volume;
+    const double targetWidth = std::cbrt(3.0 * 1.5 * neighborsPerAtom / (4.0 * M_PI * density));
+
+    double widths[3];
+    size_t totalBins = 1;
+    for(int dim = 0; dim < 3; dim++){
+        widths[dim] = volume / std::sqrt(dot(faceNormals[dim], faceNormals[dim]));
+        _bins[dim] = std::max(1, (int) std::min(widths[dim] / targetWidth, 1024.0));
+        totalBins *= (size_t) _bins[dim];
+    }
+
+    _minBinWidth = widths[0] / _bins[0];
+    _maxRing = 0;
+    for(int dim = 0; dim < 3; dim++){
+        _minBinWidth = std::min(_minBinWidth, widths[dim] / _bins[dim]);
+        _maxRing = std::max(_maxRing, _pbc[dim] ? 2 * _bins[dim] + 2 : _bins[dim]);
+    }
+
+    // Wrap atoms into the primary cell and assign them to bins.
+    const Point3 origin = cell.cellOrigin();
+    _atomBins.resize(count);
+    _wrappedPositions.resize(count);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, count, 4096), [&](const tbb::blocked_range<size_t>& r){
+        for(size_t i = r.begin(); i != r.end(); ++i){
+            double reduced[3];
+            if(_orthogonal){
+                for(int dim = 0; dim < 3; dim++){
+                    reduced[dim] = (positions[i][dim] - origin[dim]) / _boxLengths[dim];
+                }
+            }else{
+                const Point3 rp = cell.absoluteToReduced(positions[i]);
+                for(int dim = 0; dim < 3; dim++){
+                    reduced[dim] = rp[dim];
+                }
+            }
+
+            Point3 wrapped = positions[i];
+            int binCoords[3];
+            for(int dim = 0; dim < 3; dim++){
+                if(_pbc[dim]){
+                    const double image = std::floor(reduced[dim]);
+                    reduced[dim] -= image;
+                    for(int k = 0; k < 3; k++){
+                        wrapped[k] -= image * _cellVectors[dim][k];
+                    }
+                }
+                binCoords[dim] = std::clamp((int) std::floor(reduced[dim] * _bins[dim]), 0, _bins[dim] - 1);
+            }
+
+            _wrappedPositions[i] = wrapped;
+            _atomBins[i] = binCoords[0] + size_t(_bins[0]) * (binCoords[1] + size_t(_bins[1]) * binCoords[2]);
+        }
+    });
+
+    // Counting sort by bin keeps ascending atom order within each bin.
+    _binOffsets.assign(totalBins + 1, 0);
+    for(size_t i = 0; i < count; i++){
+        _binOffsets[_atomBins[i] + 1]++;
+    }
+    for(size_t bin = 0; bin < totalBins; bin++){
+        _binOffsets[bin + 1] += _binOffsets[bin];
+    }
+
+    _binAtoms.resize(count);
+    _binX.resize(count);
+    _binY.resize(count);
+    _binZ.resize(count);
+    std::vector<size_t> fill(_binOffsets.begin(), _binOffsets.end() - 1);
+    for(size_t i = 0; i < count; i++){
+        const size_t slot = fill[_atomBins[i]]++;
+        _binAtoms[slot] = i;
+        _binX[slot] = _wrappedPositions[i].x();
+        _binY[slot] = _wrappedPositions[i].y();
+        _binZ[slot] = _wrappedPositions[i].z();
+    }
+
+    return true;
+}
+
+}
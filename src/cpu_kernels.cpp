@@ -0,0 +1,232 @@
+#include <volt/cpu_kernels.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+#ifdef VOLT_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace Volt{
+
+namespace{
+
+KernelIsa detectKernelIsa(){
+#ifdef VOLT_X86_KERNELS
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f")) return KernelIsa::Avx512;
+    if(__builtin_cpu_supports("avx2")) return KernelIsa::Avx2;
+#endif
+    return KernelIsa::Scalar;
+}
+
+// exp(x) for x <= 0 as 2^k * p(r) with x = k ln2 + r and a degree 12 Taylor polynomial
+// on |r| <= ln2 / 2, accurate to about one ulp. The vector variants repeat the same
+// operations in the same order, which std::exp cannot promise.
+constexpr double Log2e = 1.44269504088896338700e+00;
+constexpr double Ln2Hi = 6.93147180369123816490e-01;
+constexpr double Ln2Lo = 1.90821492927058770002e-10;
+constexpr double ExponentMagic = 4503599627370496.0 + 1023.0;   // 2^52 + exponent bias
+constexpr double MinExponent = -700.0;
+constexpr double ZeroAngle = 1e-5;
+constexpr int ExpDegree = 12;
+constexpr double ExpCoefficients[ExpDegree + 1] = {
+    1.0,
+    1.0,
+    1.0 / 2.0,
+    1.0 / 6.0,
+    1.0 / 24.0,
+    1.0 / 120.0,
+    1.0 / 720.0,
+    1.0 / 5040.0,
+    1.0 / 40320.0,
+    1.0 / 362880.0,
+    1.0 / 3628800.0,
+    1.0 / 39916800.0,
+    1.0 / 479001600.0
+};
+
+inline double graphWeight(float disorientation){
+    double theta = disorientation;
+    if(theta < ZeroAngle){
+        theta = 0.0;
+    }
+
+    const double x = std::max(-(1.0 / 3.0) * theta * theta, MinExponent);
+    const double k = std::nearbyint(x * Log2e);
+    const double r = (x - k * Ln2Hi) - k * Ln2Lo;
+
+    double p = ExpCoefficients[ExpDegree];
+    for(int c = ExpDegree - 1; c >= 0; --c){
+        p = p * r + ExpCoefficients[c];
+    }
+    return p * std::bit_cast<double>(std::bit_cast<uint64_t>(k + ExponentMagic) << 52);
+}
+
+void graphWeightsScalar(const float* disorientations, size_t begin, size_t count, double* out){
+    for(size_t i = begin; i < count; ++i){
+        out[i] = graphWeight(disorientations[i]);
+    }
+}
+
+void squaredDistancesScalar(const double* x, const double* y, const double* z, size_t begin, size_t count, double cx, double cy, double cz, double* out){
+    for(size_t i = begin; i < count; ++i){
+        const double dx = x[i] - cx;
+        const double dy = y[i] - cy;
+        const double dz = z[i] - cz;
+        out[i] = dx * dx + dy * dy + dz * dz;
+    }
+}
+
+#ifdef VOLT_X86_KERNELS
+
+__attribute__((target("avx2")))
+void graphWeightsAvx2(const float* disorientations, size_t count, double* out){
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4){
+        __m256d theta = _mm256_cvtps_pd(_mm_loadu_ps(disorientations + i));
+        theta = _mm256_and_pd(theta, _mm256_cmp_pd(theta, _mm256_set1_pd(ZeroAngle), _CMP_GE_OQ));
+
+        const __m256d x = _mm256_max_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(-(1.0 / 3.0)), theta), theta), _mm256_set1_pd(MinExponent));
+        const __m256d k = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(Log2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        const __m256d r = _mm256_sub_pd(_mm256_sub_pd(x, _mm256_mul_pd(k, _mm256_set1_pd(Ln2Hi))), _mm256_mul_pd(k, _mm256_set1_pd(Ln2Lo)));
+
+        __m256d p = _mm256_set1_pd(ExpCoefficients[ExpDegree]);
+        for(int c = ExpDegree - 1; c >= 0; --c){
+            p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(ExpCoefficients[c]));
+        }
+        const __m256i scale = _mm256_slli_epi64(_mm256_castpd_si256(_mm256_add_pd(k, _mm256_set1_pd(ExponentMagic))), 52);
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(p, _mm256_castsi256_pd(scale)));
+    }
+    graphWeightsScalar(disorientations, i, count, out);
+}
+
+__attribute__((target("avx512f")))
+void graphWeightsAvx512(const float* disorientations, size_t count, double* out){
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8){
+        __m512d theta = _mm512_cvtps_pd(_mm256_loadu_ps(disorientations + i));
+        theta = _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(theta, _mm512_set1_pd(ZeroAngle), _CMP_GE_OQ), theta);
+
+        const __m512d x = _mm512_max_pd(_mm512_mul_pd(_mm512_mul_pd(_mm512_set1_pd(-(1.0 / 3.0)), theta), theta), _mm512_set1_pd(MinExponent));
+        const __m512d k = _mm512_roundscale_pd(_mm512_mul_pd(x, _mm512_set1_pd(Log2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        const __m512d r = _mm512_sub_pd(_mm512_sub_pd(x, _mm512_mul_pd(k, _mm512_set1_pd(Ln2Hi))), _mm512_mul_pd(k, _mm512_set1_pd(Ln2Lo)));
+
+        __m512d p = _mm512_set1_pd(ExpCoefficients[ExpDegree]);
+        for(int c = ExpDegree - 1; c >= 0; --c){
+            p = _mm512_add_pd(_mm512_mul_pd(p, r), _mm512_set1_pd(ExpCoefficients[c]));
+        }
+        const __m512i scale = _mm512_slli_epi64(_mm512_castpd_si512(_mm512_add_pd(k, _mm512_set1_pd(ExponentMagic))), 52);
+        _mm512_storeu_pd(out + i, _mm512_mul_pd(p, _mm512_castsi512_pd(scale)));
+    }
+    graphWeightsScalar(disorientations, i, count, out);
+}
+
+__attribute__((target("avx2")))
+void squaredDistancesAvx2(const double* x, const double* y, const double* z, size_t count, double cx, double cy, double cz, double* out){
+    const __m256d centerX = _mm256_set1_pd(cx);
+    const __m256d centerY = _mm256_set1_pd(cy);
+    const __m256d centerZ = _mm256_set1_pd(cz);
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4){
+        const __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(x + i), centerX);
+        const __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(y + i), centerY);
+        const __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(z + i), centerZ);
+        _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)), _mm256_mul_pd(dz, dz)));
+    }
+    squaredDistancesScalar(x, y, z, i, count, cx, cy, cz, out);
+}
+
+__attribute__((target("avx512f")))
+void squaredDistancesAvx512(const double* x, const double* y, const double* z, size_t count, double cx, double cy, double cz, double* out){
+    const __m512d centerX = _mm512_set1_pd(cx);
+    const __m512d centerY = _mm512_set1_pd(cy);
+    const __m512d centerZ = _mm512_set1_pd(cz);
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8){
+        const __m512d dx = _mm512_sub_pd(_mm512_loadu_pd(x + i), centerX);
+        const __m512d dy = _mm512_sub_pd(_mm512_loadu_pd(y + i), centerY);
+        const __m512d dz = _mm512_sub_pd(_mm512_loadu_pd(z + i), centerZ);
+        _mm512_storeu_pd(out + i, _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy)), _mm512_mul_pd(dz, dz)));
+    }
+    squaredDistancesScalar(x, y, z, i, count, cx, cy, cz, out);
+}
+
+#endif
+
+void graphWeightsDefault(const float* disorientations, size_t count, double* out){
+    graphWeightsScalar(disorientations, 0, count, out);
+}
+
+void squaredDistancesDefault(const double* x, const double* y, const double* z, size_t count, double cx, double cy, double cz, double* out){
+    squaredDistancesScalar(x, y, z, 0, count, cx, cy, cz, out);
+}
+
+using GraphWeightsKernel = void (*)(const float*, size_t, double*);
+using SquaredDistancesKernel = void (*)(const double*, const double*, const double*, size_t, double, double, double, double*);
+
+GraphWeightsKernel graphWeightsKernel(KernelIsa isa){
+#ifdef VOLT_X86_KERNELS
+    switch(isa){
+        case KernelIsa::Avx512: return graphWeightsAvx512;
+        case KernelIsa::Avx2: return graphWeightsAvx2;
+        default: break;
+    }
+#endif
+    return graphWeightsDefault;
+}
+
+SquaredDistancesKernel selectSquaredDistancesKernel(){
+#ifdef VOLT_X86_KERNELS
+    switch(kernelIsa()){
+        case KernelIsa::Avx512: return squaredDistancesAvx512;
+        case KernelIsa::Avx2: return squaredDistancesAvx2;
+        default: break;
+    }
+#endif
+    return squaredDistancesDefault;
+}
+
+}
+
+KernelIsa kernelIsa(){
+    static const KernelIsa isa = detectKernelIsa();
+    return isa;
+}
+
+bool kernelIsaSupported(KernelIsa isa){
+    if(isa == KernelIsa::Scalar) return true;
+#ifdef VOLT_X86_KERNELS
+    kernelIsa();    // initializes the CPU feature flags once
+    if(isa == KernelIsa::Avx512) return __builtin_cpu_supports("avx512f");
+    if(isa == KernelIsa::Avx2) return __builtin_cpu_supports("avx2");
+#endif
+    return false;
+}
+
+const char* kernelIsaName(KernelIsa isa){
+    switch(isa){
+        case KernelIsa::Avx512: return "avx512";
+        case KernelIsa::Avx2: return "avx2";
+        case KernelIsa::Scalar: return "scalar";
+    }
+    return "unknown";
+}
+
+void computeGraphWeights(const float* disorientations, size_t count, double* out){
+    static const GraphWeightsKernel kernel = graphWeightsKernel(kernelIsa());
+    kernel(disorientations, count, out);
+}
+
+void computeGraphWeights(KernelIsa isa, const float* disorientations, size_t count, double* out){
+    graphWeightsKernel(kernelIsaSupported(isa) ? isa : KernelIsa::Scalar)(disorientations, count, out);
+}
+
+void computeSquaredDistances(const double* x, const double* y, const double* z, size_t count, double cx, double cy, double cz, double* out){
+    static const SquaredDistancesKernel kernel = selectSquaredDistancesKernel();
+    kernel(x, y, z, count, cx, cy, cz, out);
+}
+
+}
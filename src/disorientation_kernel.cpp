@@ -0,0 +1,305 @@
+#include <volt/disorientation_kernel.h>
+#include <volt/cpu_kernels.h>
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef VOLT_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace Volt{
+
+namespace{
+
+constexpr double HalfSqrt2 = 0.70710678118654752440;
+constexpr double HalfSqrt3 = 0.86602540378443864676;
+
+// Symmetry operators as (w, x, y, z). Only |x . g| is used, so the sign of each
+// quaternion is irrelevant.
+constexpr double CubicOperators[24][4] = {
+    { 1.0, 0.0, 0.0, 0.0 },
+    { 0.0, 1.0, 0.0, 0.0 },
+    { 0.0, 0.0, 1.0, 0.0 },
+    { 0.0, 0.0, 0.0, 1.0 },
+    { HalfSqrt2,  HalfSqrt2, 0.0, 0.0 },
+    { HalfSqrt2, -HalfSqrt2, 0.0, 0.0 },
+    { HalfSqrt2, 0.0,  HalfSqrt2, 0.0 },
+    { HalfSqrt2, 0.0, -HalfSqrt2, 0.0 },
+    { HalfSqrt2, 0.0, 0.0,  HalfSqrt2 },
+    { HalfSqrt2, 0.0, 0.0, -HalfSqrt2 },
+    { 0.0, HalfSqrt2,  HalfSqrt2, 0.0 },
+    { 0.0, HalfSqrt2, -HalfSqrt2, 0.0 },
+    { 0.0, HalfSqrt2, 0.0,  HalfSqrt2 },
+    { 0.0, HalfSqrt2, 0.0, -HalfSqrt2 },
+    { 0.0, 0.0, HalfSqrt2,  HalfSqrt2 },
+    { 0.0, 0.0, HalfSqrt2, -HalfSqrt2 },
+    { 0.5,  0.5,  0.5,  0.5 },
+    { 0.5,  0.5,  0.5, -0.5 },
+    { 0.5,  0.5, -0.5,  0.5 },
+    { 0.5,  0.5, -0.5, -0.5 },
+    { 0.5, -0.5,  0.5,  0.5 },
+    { 0.5, -0.5,  0.5, -0.5 },
+    { 0.5, -0.5, -0.5,  0.5 },
+    { 0.5, -0.5, -0.5, -0.5 }
+};
+
+// Conventional hexagonal frame: c along z, six-fold about z and two-fold about the
+// in-plane axes.
+constexpr double HexagonalOperators[12][4] = {
+    { 1.0, 0.0, 0.0, 0.0 },
+    { HalfSqrt3, 0.0, 0.0, 0.5 },
+    { 0.5, 0.0, 0.0, HalfSqrt3 },
+    { 0.0, 0.0, 0.0, 1.0 },
+    { -0.5, 0.0, 0.0, HalfSqrt3 },
+    { -HalfSqrt3, 0.0, 0.0, 0.5 },
+    { 0.0, 1.0, 0.0, 0.0 },
+    { 0.0, HalfSqrt3, 0.5, 0.0 },
+    { 0.0, 0.5, HalfSqrt3, 0.0 },
+    { 0.0, 0.0, 1.0, 0.0 },
+    { 0.0, -0.5, HalfSqrt3, 0.0 },
+    { 0.0, -HalfSqrt3, 0.5, 0.0 }
+};
+
+// If the identity already gives |x . I| = cos(theta0 / 2) with theta0 below half the
+// smallest non-trivial symmetry rotation (90 degrees cubic, 60 degrees hexagonal), every
+// other operator gives an angle of at least that half, so the search can stop. This is
+// the common case once both orientations are in the fundamental zone.
+constexpr double CubicIdentityBound = 0.92387953251128675613;      // cos(22.5 deg)
+constexpr double HexagonalIdentityBound = 0.96592582628906828675;  // cos(15 deg)
+
+inline float angleDegrees(double maxDot){
+    return (float) (2.0 * std::acos(std::min(1.0, maxDot)) * (180.0 / M_PI));
+}
+
+// The misorientation x = conj(a) * b is compared against every operator g; the
+// largest |x . g| belongs to the smallest rotation angle.
+template<int N>
+void disorientationsScalar(const double (&ops)[N][4], double identityBound, const QuaternionBatch& a, const QuaternionBatch& b, size_t begin, size_t end, float* out){
+    for(size_t i = begin; i < end; ++i){
+        const double ax = a.x[i], ay = a.y[i], az = a.z[i], aw = a.w[i];
+        const double bx = b.x[i], by = b.y[i], bz = b.z[i], bw = b.w[i];
+
+        const double xw = aw * bw + ax * bx + ay * by + az * bz;
+        const double xx = aw * bx - bw * ax - (ay * bz - az * by);
+        const double xy = aw * by - bw * ay - (az * bx - ax * bz);
+        const double xz = aw * bz - bw * az - (ax * by - ay * bx);
+
+        if(std::abs(xw) >= identityBound){
+            out[i] = angleDegrees(std::abs(xw));
+            continue;
+        }
+
+        double best = 0.0;
+        for(int k = 0; k < N; ++k){
+            const double d = xw * ops[k][0] + xx * ops[k][1] + xy * ops[k][2] + xz * ops[k][3];
+            best = std::max(best, std::abs(d));
+        }
+        out[i] = angleDegrees(best);
+    }
+}
+
+#ifdef VOLT_X86_KERNELS
+
+// Plain multiplies and adds rather than FMA, so that every variant rounds the same way.
+template<int N>
+__attribute__((target("avx512f")))
+void disorientationsAvx512(const double (&ops)[N][4], double identityBound, const QuaternionBatch& a, const QuaternionBatch& b, size_t count, float* out){
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8){
+        const __m512d ax = _mm512_loadu_pd(a.x + i), ay = _mm512_loadu_pd(a.y + i);
+        const __m512d az = _mm512_loadu_pd(a.z + i), aw = _mm512_loadu_pd(a.w + i);
+        const __m512d bx = _mm512_loadu_pd(b.x + i), by = _mm512_loadu_pd(b.y + i);
+        const __m512d bz = _mm512_loadu_pd(b.z + i), bw = _mm512_loadu_pd(b.w + i);
+
+        const __m512d xw = _mm512_add_pd(_mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(aw, bw), _mm512_mul_pd(ax, bx)), _mm512_mul_pd(ay, by)), _mm512_mul_pd(az, bz));
+        const __m512d xx = _mm512_sub_pd(_mm512_sub_pd(_mm512_mul_pd(aw, bx), _mm512_mul_pd(bw, ax)), _mm512_sub_pd(_mm512_mul_pd(ay, bz), _mm512_mul_pd(az, by)));
+        const __m512d xy = _mm512_sub_pd(_mm512_sub_pd(_mm512_mul_pd(aw, by), _mm512_mul_pd(bw, ay)), _mm512_sub_pd(_mm512_mul_pd(az, bx), _mm512_mul_pd(ax, bz)));
+        const __m512d xz = _mm512_sub_pd(_mm512_sub_pd(_mm512_mul_pd(aw, bz), _mm512_mul_pd(bw, az)), _mm512_sub_pd(_mm512_mul_pd(ax, by), _mm512_mul_pd(ay, bx)));
+
+        __m512d best = _mm512_abs_pd(xw);
+        const bool identityWins = _mm512_cmp_pd_mask(best, _mm512_set1_pd(identityBound), _CMP_GE_OQ) == 0xFF;
+        for(int k = 0; k < N && !identityWins; ++k){
+            const __m512d d = _mm512_add_pd(_mm512_add_pd(_mm512_add_pd(
+                _mm512_mul_pd(xw, _mm512_set1_pd(ops[k][0])), _mm512_mul_pd(xx, _mm512_set1_pd(ops[k][1]))),
+                _mm512_mul_pd(xy, _mm512_set1_pd(ops[k][2]))), _mm512_mul_pd(xz, _mm512_set1_pd(ops[k][3])));
+            best = _mm512_max_pd(best, _mm512_abs_pd(d));
+        }
+
+        alignas(64) double lanes[8];
+        _mm512_store_pd(lanes, best);
+        for(int l = 0; l < 8; ++l){
+            out[i + l] = angleDegrees(lanes[l]);
+        }
+    }
+    disorientationsScalar(ops, identityBound, a, b, i, count, out);
+}
+
+template<int N>
+__attribute__((target("avx2")))
+void disorientationsAvx2(const double (&ops)[N][4], double identityBound, const QuaternionBatch& a, const QuaternionBatch& b, size_t count, float* out){
+    const __m256d signMask = _mm256_set1_pd(-0.0);
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4){
+        const __m256d ax = _mm256_loadu_pd(a.x + i), ay = _mm256_loadu_pd(a.y + i);
+        const __m256d az = _mm256_loadu_pd(a.z + i), aw = _mm256_loadu_pd(a.w + i);
+        const __m256d bx = _mm256_loadu_pd(b.x + i), by = _mm256_loadu_pd(b.y + i);
+        const __m256d bz = _mm256_loadu_pd(b.z + i), bw = _mm256_loadu_pd(b.w + i);
+
+        const __m256d xw = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(aw, bw), _mm256_mul_pd(ax, bx)),
+                                         _mm256_mul_pd(ay, by)), _mm256_mul_pd(az, bz));
+        const __m256d xx = _mm256_sub_pd(_mm256_sub_pd(_mm256_mul_pd(aw, bx), _mm256_mul_pd(bw, ax)),
+                                         _mm256_sub_pd(_mm256_mul_pd(ay, bz), _mm256_mul_pd(az, by)));
+        const __m256d xy = _mm256_sub_pd(_mm256_sub_pd(_mm256_mul_pd(aw, by), _mm256_mul_pd(bw, ay)),
+                                         _mm256_sub_pd(_mm256_mul_pd(az, bx), _mm256_mul_pd(ax, bz)));
+        const __m256d xz = _mm256_sub_pd(_mm256_sub_pd(_mm256_mul_pd(aw, bz), _mm256_mul_pd(bw, az)),
+                                         _mm256_sub_pd(_mm256_mul_pd(ax, by), _mm256_mul_pd(ay, bx)));
+
+        __m256d best = _mm256_andnot_pd(signMask, xw);
+        const bool identityWins = _mm256_movemask_pd(_mm256_cmp_pd(best, _mm256_set1_pd(identityBound), _CMP_GE_OQ)) == 0xF;
+        for(int k = 0; k < N && !identityWins; ++k){
+            const __m256d d = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(
+                _mm256_mul_pd(xw, _mm256_set1_pd(ops[k][0])), _mm256_mul_pd(xx, _mm256_set1_pd(ops[k][1]))),
+                _mm256_mul_pd(xy, _mm256_set1_pd(ops[k][2]))), _mm256_mul_pd(xz, _mm256_set1_pd(ops[k][3])));
+            best = _mm256_max_pd(best, _mm256_andnot_pd(signMask, d));
+        }
+
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, best);
+        for(int l = 0; l < 4; ++l){
+            out[i + l] = angleDegrees(lanes[l]);
+        }
+    }
+    disorientationsScalar(ops, identityBound, a, b, i, count, out);
+}
+
+#endif
+
+template<int N>
+void disorientations(const double (&ops)[N][4], double identityBound, const QuaternionBatch& a, const QuaternionBatch& b, size_t count, float* out){
+#ifdef VOLT_X86_KERNELS
+    static const KernelIsa isa = kernelIsa();
+    if(isa == KernelIsa::Avx512){
+        disorientationsAvx512(ops, identityBound, a, b, count, out);
+        return;
+    }
+    if(isa == KernelIsa::Avx2){
+        disorientationsAvx2(ops, identityBound, a, b, count, out);
+        return;
+    }
+#endif
+    disorientationsScalar(ops, identityBound, a, b, 0, count, out);
+}
+
+constexpr double QuantizationScale = 32767.0;
+
+// 2 asin(s) in degrees, tabulated on [0, Range] and linearly interpolated. The range
+// covers sin(theta / 2) of both identity regions (22.5 and 15 degrees).
+class HalfAngleTable{
+public:
+    static constexpr int Size = 1024;
+    static constexpr double Range = 0.5;
+
+    HalfAngleTable(){
+        for(int i = 0; i <= Size; ++i){
+            _degrees[i] = 2.0 * std::asin(i * (Range / Size)) * (180.0 / M_PI);
+        }
+    }
+
+    float operator()(double s) const{
+        const double t = std::min(s * (Size / Range), Size - 1e-9);
+        const int i = (int) t;
+        return (float) (_degrees[i] + (t - i) * (_degrees[i + 1] - _degrees[i]));
+    }
+
+private:
+    double _degrees[Size + 1];
+};
+
+// The vector part of x = conj(a) * b is evaluated in integers; its length is
+// sin(theta / 2) of the identity misorientation.
+void approximate(double identityBound, const QuantizedQuaternion* a, const QuantizedQuaternion* b, size_t count, float* out){
+    static const HalfAngleTable table;
+    constexpr double norm = 1.0 / (QuantizationScale * QuantizationScale);
+    const double maxSinSq = 1.0 - identityBound * identityBound;
+
+    for(size_t i = 0; i < count; ++i){
+        const int64_t ax = a[i].x, ay = a[i].y, az = a[i].z, aw = a[i].w;
+        const int64_t bx = b[i].x, by = b[i].y, bz = b[i].z, bw = b[i].w;
+
+        const double vx = (double) (aw * bx - bw * ax - (ay * bz - az * by)) * norm;
+        const double vy = (double) (aw * by - bw * ay - (az * bx - ax * bz)) * norm;
+        const double vz = (double) (aw * bz - bw * az - (ax * by - ay * bx)) * norm;
+
+        const double sinSq = vx * vx + vy * vy + vz * vz;
+        out[i] = (sinSq <= maxSinSq) ? table(std::sqrt(sinSq)) : -1.0f;
+    }
+}
+
+// Replaces q by the equivalent q * g with the largest |w|, i.e. the smallest rotation
+// angle, and makes w non-negative.
+template<int N>
+void reduce(const double (&ops)[N][4], double q[4]){
+    const double qx = q[0], qy = q[1], qz = q[2], qw = q[3];
+
+    int bestOp = 0;
+    double best = -1.0;
+    for(int k = 0; k < N; ++k){
+        const double w = std::abs(qw * ops[k][0] - qx * ops[k][1] - qy * ops[k][2] - qz * ops[k][3]);
+        if(w > best){
+            best = w;
+            bestOp = k;
+        }
+    }
+
+    const double gw = ops[bestOp][0], gx = ops[bestOp][1], gy = ops[bestOp][2], gz = ops[bestOp][3];
+    double r[4] = {
+        qw * gx + gw * qx + (qy * gz - qz * gy),
+        qw * gy + gw * qy + (qz * gx - qx * gz),
+        qw * gz + gw * qz + (qx * gy - qy * gx),
+        qw * gw - (qx * gx + qy * gy + qz * gz)
+    };
+    const double sign = (r[3] < 0.0) ? -1.0 : 1.0;
+    for(int k = 0; k < 4; ++k){
+        q[k] = sign * r[k];
+    }
+}
+
+}
+
+template<>
+void computeDisorientations<CrystalSymmetry::Cubic>(const QuaternionBatch& a, const QuaternionBatch& b, size_t count, float* out){
+    disorientations(CubicOperators, CubicIdentityBound, a, b, count, out);
+}
+
+template<>
+void computeDisorientations<CrystalSymmetry::Hexagonal>(const QuaternionBatch& a, const QuaternionBatch& b, size_t count, float* out){
+    disorientations(HexagonalOperators, HexagonalIdentityBound, a, b, count, out);
+}
+
+QuantizedQuaternion quantizeOrientation(const double q[4]){
+    auto component = [](double c){
+        return (int16_t) std::lround(std::clamp(c, -1.0, 1.0) * QuantizationScale);
+    };
+    return { component(q[0]), component(q[1]), component(q[2]), component(q[3]) };
+}
+
+template<>
+void approximateDisorientations<CrystalSymmetry::Cubic>(const QuantizedQuaternion* a, const QuantizedQuaternion* b, size_t count, float* out){
+    approximate(CubicIdentityBound, a, b, count, out);
+}
+
+template<>
+void approximateDisorientations<CrystalSymmetry::Hexagonal>(const QuantizedQuaternion* a, const QuantizedQuaternion* b, size_t count, float* out){
+    approximate(HexagonalIdentityBound, a, b, count, out);
+}
+
+void reduceToFundamentalZone(CrystalSymmetry symmetry, double q[4]){
+    if(symmetry == CrystalSymmetry::Cubic){
+        reduce(CubicOperators, q);
+    }else{
+        reduce(HexagonalOperators, q);
+    }
+}
+
+}
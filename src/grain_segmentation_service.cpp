@@ -1,11 +1,19 @@
 #include <volt/grain_segmentation_service.h>
+#include <volt/cpu_kernels.h>
 #include <volt/analysis/ptm_structure_analysis.h>
 #include <volt/core/frame_adapter.h>
 #include <volt/core/analysis_result.h>
 #include <volt/utilities/json_utils.h>
 #include <spdlog/spdlog.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
 #include <map>
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
 #include <utility>
 
 namespace Volt{
@@ -47,6 +55,127 @@ std::string structureTypeNameForExport(int structureType){
     }
 }
 
+// Collects the neighbor lists found by the PTM stage into the table consumed by
+// GrainSegmentationEngine1, so the engine does not have to search them again. PTM keeps
+// the neighbors it matched the template against in template order; for the diamond
+// types these are the 4 nearest neighbors and the 12 neighbors of those, which form the
+// second shell. Rows are therefore sorted by distance here, as the engine takes the
+// first desired_ptm_neighbor_count entries. Atoms PTM could not match need not keep a
+// full list; the engine searches the neighbors of those atoms itself.
+template<typename Index, typename Real>
+typename GrainSegmentationEngine1<Index, Real>::NeighborTable neighborTableFromPtmStates(
+    const ParticleProperty& positions,
+    const SimulationCell& simulationCell,
+    const std::vector<PtmLocalAtomState>& ptmStates
+){
+    using Engine = GrainSegmentationEngine1<Index, Real>;
+    const size_t natoms = positions.size();
+    const Point3* points = positions.constDataPoint3();
+
+    typename Engine::NeighborTable table;
+    table.offsets.resize(natoms + 1);
+    table.offsets[0] = 0;
+    for(size_t i = 0; i < natoms; i++){
+        table.offsets[i + 1] = table.offsets[i] + static_cast<size_t>(ptmStates[i].numNeighbors);
+    }
+
+    table.indices.resize(table.offsets[natoms]);
+    table.distancesSq.resize(table.offsets[natoms]);
+
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, natoms, 1024), [&](const tbb::blocked_range<size_t>& r){
+        std::array<std::pair<double, size_t>, PTM::MAX_INPUT_NEIGHBORS> row;
+        for(size_t i = r.begin(); i != r.end(); ++i){
+            const auto& state = ptmStates[i];
+            for(int j = 0; j < state.numNeighbors; j++){
+                const size_t nb = state.neighborIndices[j];
+                const Vector3 delta = simulationCell.wrapVector(points[nb] - points[i]);
+                row[j] = { delta.squaredLength(), nb };
+            }
+            std::sort(row.begin(), row.begin() + state.numNeighbors);
+
+            const size_t first = table.offsets[i];
+            for(int j = 0; j < state.numNeighbors; j++){
+                table.indices[first + j] = static_cast<Index>(row[j].second);
+                table.distancesSq[first + j] = row[j].first;
+            }
+        }
+    });
+
+    return table;
+}
+
+// Spreads the low 21 bits of v so that two zero bits separate consecutive bits.
+uint64_t spreadMortonBits(uint64_t v){
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffULL;
+    v = (v | v << 16) & 0x1f0000ff0000ffULL;
+    v = (v | v << 8) & 0x100f00f00f00f00fULL;
+    v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+    v = (v | v << 2) & 0x1249249249249249ULL;
+    return v;
+}
+
+// Orders the atoms along a Morton curve through the simulation cell, so that atoms
+// that are close in space are also close in memory. order[k] is the input index of
+// the k-th atom in the new order. Returns an empty order if the frame is incomplete.
+std::vector<size_t> spatialSortOrder(const LammpsParser::Frame& frame){
+    const size_t natoms = static_cast<size_t>(frame.natoms);
+    if(frame.positions.size() != natoms){
+        return {};
+    }
+
+    bool pbc[3];
+    for(int dim = 0; dim < 3; dim++){
+        pbc[dim] = frame.simulationCell.hasPbc(dim);
+    }
+
+    constexpr double gridSize = double((1 << 21) - 1);
+    std::vector<std::pair<uint64_t, size_t>> keys(natoms);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, natoms, 4096), [&](const tbb::blocked_range<size_t>& r){
+        for(size_t i = r.begin(); i != r.end(); ++i){
+            const Point3 reduced = frame.simulationCell.absoluteToReduced(frame.positions[i]);
+            uint64_t code = 0;
+            for(int dim = 0; dim < 3; dim++){
+                // Periodic images belong next to their wrapped position.
+                double t = reduced[dim];
+                if(pbc[dim]){
+                    t -= std::floor(t);
+                }
+                t = std::clamp(t, 0.0, 1.0);
+                code |= spreadMortonBits(static_cast<uint64_t>(t * gridSize)) << dim;
+            }
+            keys[i] = { code, i };
+        }
+    });
+
+    tbb::parallel_sort(keys.begin(), keys.end());
+
+    std::vector<size_t> order(natoms);
+    for(size_t k = 0; k < natoms; k++){
+        order[k] = keys[k].second;
+    }
+    return order;
+}
+
+// Positions in the given order. They are the only per-atom input of PTM and the
+// engines; everything else is read from the input frame through order, so no per-atom
+// array of the frame can be left in the wrong order.
+std::unique_ptr<ParticleProperty> reorderPositions(const ParticleProperty& positions, const std::vector<size_t>& order){
+    auto reordered = std::make_unique<ParticleProperty>(positions.size(), ParticleProperty::PositionProperty, 0, false);
+    const Point3* points = positions.constDataPoint3();
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, order.size(), 4096), [&](const tbb::blocked_range<size_t>& r){
+        for(size_t k = r.begin(); k != r.end(); ++k){
+            reordered->setPoint3(k, points[order[k]]);
+        }
+    });
+    return reordered;
+}
+
+// Input index of the atom analyzed at position k.
+inline size_t inputIndex(const std::vector<size_t>& order, size_t k){
+    return order.empty() ? k : order[k];
+}
+
 }
 
 GrainSegmentationService::GrainSegmentationService()
@@ -54,7 +183,14 @@ GrainSegmentationService::GrainSegmentationService()
       _adoptOrphanAtoms(true),
       _minGrainAtomCount(100),
       _handleCoherentInterfaces(true),
-      _outputBonds(false){}
+      _outputBonds(false),
+      _spatialReordering(false),
+      _neighborBackend(NeighborSearchBackend::PTM),
+      _interfacePropagation(InterfacePropagation::Serial),
+      _interfaceCache(false),
+      _orientationPrecision(OrientationPrecision::Double),
+      _disorientationMode(DisorientationMode::Exact),
+      _clusteringMode(ClusteringMode::Chain){}
 
 void GrainSegmentationService::setRMSD(float rmsd){
     _rmsd = rmsd;
@@ -72,6 +208,34 @@ void GrainSegmentationService::setParameters(
     _outputBonds = outputBonds;
 }
 
+void GrainSegmentationService::setSpatialReordering(bool enabled){
+    _spatialReordering = enabled;
+}
+
+void GrainSegmentationService::setNeighborBackend(NeighborSearchBackend backend){
+    _neighborBackend = backend;
+}
+
+void GrainSegmentationService::setInterfacePropagation(InterfacePropagation propagation){
+    _interfacePropagation = propagation;
+}
+
+void GrainSegmentationService::setInterfaceCache(bool enabled){
+    _interfaceCache = enabled;
+}
+
+void GrainSegmentationService::setOrientationPrecision(OrientationPrecision precision){
+    _orientationPrecision = precision;
+}
+
+void GrainSegmentationService::setDisorientationMode(DisorientationMode mode){
+    _disorientationMode = mode;
+}
+
+void GrainSegmentationService::setClusteringMode(ClusteringMode mode){
+    _clusteringMode = mode;
+}
+
 json GrainSegmentationService::compute(const LammpsParser::Frame &frame, const std::string &outputFilename){
     FrameAdapter::PreparedAnalysisInput prepared;
     std::string frameError;
@@ -80,6 +244,19 @@ json GrainSegmentationService::compute(const LammpsParser::Frame &frame, const s
 
     auto positions = std::move(prepared.positions);
 
+    // PTM and both engines run on the spatially sorted positions; results are mapped
+    // back to the input order before they are exported.
+    std::vector<size_t> order;
+    if(_spatialReordering){
+        order = spatialSortOrder(frame);
+        if(order.empty()){
+            spdlog::warn("Frame is incomplete, skipping spatial reordering");
+        }else{
+            spdlog::info("Reordering atoms along a Morton curve");
+            positions = reorderPositions(*positions, order);
+        }
+    }
+
     std::vector<Matrix3> preferredOrientations;
     preferredOrientations.push_back(Matrix3::Identity());
 
@@ -106,7 +283,7 @@ json GrainSegmentationService::compute(const LammpsParser::Frame &frame, const s
 
     if(!outputFilename.empty()){
         spdlog::info("Running grain segmentation with in-memory PTM data");
-        return performGrainSegmentation(frame, extractedStructureTypes, *ptmStates, outputFilename);
+        return performGrainSegmentation(frame, order, extractedStructureTypes, *ptmStates, outputFilename);
     }
 
     return AnalysisResult::failure("No output filename specified");
@@ -114,35 +291,70 @@ json GrainSegmentationService::compute(const LammpsParser::Frame &frame, const s
 
 json GrainSegmentationService::performGrainSegmentation(
     const LammpsParser::Frame &frame,
+    const std::vector<size_t>& order,
     const std::vector<int>& structureTypes,
     const std::vector<PtmLocalAtomState>& ptmStates,
     const std::string &outputFile
 ){
     spdlog::info("Starting grain segmentation analysis...");
 
+    // Single-precision orientations halve the per-atom orientation arrays of the engines.
+    const bool single = _orientationPrecision == OrientationPrecision::Single;
+    spdlog::info("Using {} precision orientations", orientationPrecisionName(_orientationPrecision));
+
+    // 32-bit atom indices halve the per-atom and per-edge arrays of the engines.
+    if(static_cast<uint64_t>(frame.natoms) < std::numeric_limits<uint32_t>::max()){
+        spdlog::info("Using 32-bit atom indices");
+        return single
+            ? segmentGrains<uint32_t, float>(frame, order, structureTypes, ptmStates, outputFile)
+            : segmentGrains<uint32_t, double>(frame, order, structureTypes, ptmStates, outputFile);
+    }
+
+    spdlog::info("Using 64-bit atom indices");
+    return single
+        ? segmentGrains<uint64_t, float>(frame, order, structureTypes, ptmStates, outputFile)
+        : segmentGrains<uint64_t, double>(frame, order, structureTypes, ptmStates, outputFile);
+}
+
+template<typename Index, typename Real>
+json GrainSegmentationService::segmentGrains(
+    const LammpsParser::Frame &frame,
+    const std::vector<size_t>& order,
+    const std::vector<int>& analyzedStructureTypes,
+    const std::vector<PtmLocalAtomState>& ptmStates,
+    const std::string &outputFile
+){
     try{
         if(ptmStates.size() < static_cast<size_t>(frame.natoms)){
             spdlog::error("PTM state data not available for all atoms.");
             return AnalysisResult::failure("Grain segmentation requires PTM orientation state for all atoms.");
         }
 
+        // The engines see the atoms in analysis order, which differs from the input
+        // order when spatial reordering is enabled.
         auto positions = std::make_shared<ParticleProperty>(frame.natoms, ParticleProperty::PositionProperty, 0, true);
         for(size_t i = 0; i < frame.positions.size() && i < static_cast<size_t>(frame.natoms); i++){
-            positions->setPoint3(i, frame.positions[i]);
+            positions->setPoint3(i, frame.positions[inputIndex(order, i)]);
         }
 
         auto structures = std::make_shared<ParticleProperty>(frame.natoms, DataType::Int, 1, 0, false);
-        for(size_t i = 0; i < structureTypes.size(); i++){
-            structures->setInt(i, structureTypes[i]);
+        for(size_t i = 0; i < analyzedStructureTypes.size(); i++){
+            structures->setInt(i, analyzedStructureTypes[i]);
         }
 
-        auto orientations = std::make_shared<ParticleProperty>(frame.natoms, DataType::Double, 4, 0, false);
+        // In single-precision mode the input orientations are stored as float as well.
+        constexpr bool single = std::is_same_v<Real, float>;
+        auto orientations = std::make_shared<ParticleProperty>(frame.natoms, single ? DataType::Float : DataType::Double, 4, 0, false);
         for(size_t i = 0; i < static_cast<size_t>(frame.natoms); i++){
             const Quaternion q = ptmStates[i].orientation.normalized();
-            orientations->setDoubleComponent(i, 0, q.x());
-            orientations->setDoubleComponent(i, 1, q.y());
-            orientations->setDoubleComponent(i, 2, q.z());
-            orientations->setDoubleComponent(i, 3, q.w());
+            const double components[4] = { q.x(), q.y(), q.z(), q.w() };
+            for(size_t c = 0; c < 4; c++){
+                if constexpr(single){
+                    orientations->setFloatComponent(i, c, (float) components[c]);
+                }else{
+                    orientations->setDoubleComponent(i, c, components[c]);
+                }
+            }
         }
 
         auto correspondences = std::make_shared<ParticleProperty>(frame.natoms, DataType::Int64, 1, 0, false);
@@ -150,23 +362,68 @@ json GrainSegmentationService::performGrainSegmentation(
             correspondences->setInt64(i, 0);
         }
 
+        spdlog::info("Using {} kernels", kernelIsaName(kernelIsa()));
         spdlog::info("Running GrainSegmentationEngine1...");
-        auto engine1 = std::make_shared<GrainSegmentationEngine1>(
-            positions,
-            structures,
-            orientations,
-            correspondences,
-            &frame.simulationCell,
-            _handleCoherentInterfaces,
-            _outputBonds
-        );
+        std::shared_ptr<GrainSegmentationEngine1<Index, Real>> engine1;
+        if(_neighborBackend == NeighborSearchBackend::PTM){
+            engine1 = std::make_shared<GrainSegmentationEngine1<Index, Real>>(
+                positions,
+                structures,
+                orientations,
+                correspondences,
+                &frame.simulationCell,
+                neighborTableFromPtmStates<Index, Real>(*positions, frame.simulationCell, ptmStates),
+                _handleCoherentInterfaces,
+                _outputBonds
+            );
+        }else{
+            engine1 = std::make_shared<GrainSegmentationEngine1<Index, Real>>(
+                positions,
+                structures,
+                orientations,
+                correspondences,
+                &frame.simulationCell,
+                _handleCoherentInterfaces,
+                _outputBonds
+            );
+        }
+        // PTM rows too short for the atom's type are searched with the tree.
+        engine1->setNeighborBackend(_neighborBackend == NeighborSearchBackend::PTM ? NeighborSearchBackend::Tree : _neighborBackend);
+        engine1->setInterfacePropagation(_interfacePropagation);
+        engine1->setInterfaceCache(_interfaceCache);
+        engine1->setDisorientationMode(_disorientationMode);
+        engine1->setClusteringMode(_clusteringMode);
 
         engine1->perform();
 
+        if(_neighborBackend == NeighborSearchBackend::PTM){
+            spdlog::info("PTM neighbor lists: {} short rows searched again / {} atoms",
+                engine1->searchedNeighborRows(), frame.natoms);
+        }
+        spdlog::info("Coherent interface pass: {}", interfacePassName(engine1->interfacePass()));
+        const size_t interfaceCacheHits = engine1->interfaceCacheHits();
+        const size_t interfaceCacheMisses = engine1->interfaceCacheMisses();
+        if(_interfaceCache){
+            const size_t lookups = interfaceCacheHits + interfaceCacheMisses;
+            spdlog::info("Interface disorientation cache: {} hits / {} misses ({:.1f}% hit rate)",
+                interfaceCacheHits, interfaceCacheMisses, lookups ? 100.0 * interfaceCacheHits / lookups : 0.0);
+        }
+        if(_disorientationMode == DisorientationMode::Approximate){
+            const size_t fallbacks = engine1->exactFallbacks();
+            const size_t bonds = fallbacks + engine1->approximatedBonds();
+            spdlog::info("Approximate disorientations: {} exact fallbacks / {} bonds ({:.1f}%)",
+                fallbacks, bonds, bonds ? 100.0 * fallbacks / bonds : 0.0);
+        }
+        if(_clusteringMode == ClusteringMode::Chain){
+            const size_t hits = engine1->nearestNeighborHits();
+            const size_t lookups = hits + engine1->nearestNeighborRescans();
+            spdlog::info("Nearest-neighbor cache: {} rescans avoided / {} lookups ({:.1f}%)",
+                hits, lookups, lookups ? 100.0 * hits / lookups : 0.0);
+        }
         spdlog::info("GrainSegmentationEngine1 complete. Suggested merging threshold: {:.4f}", engine1->suggestedMergingThreshold());
         spdlog::info("Running GrainSegmentationEngine2...");
 
-        GrainSegmentationEngine2 engine2(
+        GrainSegmentationEngine2<Index, Real> engine2(
             engine1,
             _adoptOrphanAtoms,
             static_cast<size_t>(_minGrainAtomCount),
@@ -176,10 +433,15 @@ json GrainSegmentationService::performGrainSegmentation(
         engine2.perform();
         spdlog::info("Found {} grains", engine2.grainCount());
 
+        // Map per-atom results back to the input order.
         auto atomClusters = engine2.atomClusters();
         std::vector<int> grainIds(frame.natoms, 0);
+        std::vector<int> structureTypes(analyzedStructureTypes.size(), 0);
         for(size_t i = 0; i < static_cast<size_t>(frame.natoms); i++){
-            grainIds[i] = atomClusters->getInt(i);
+            grainIds[inputIndex(order, i)] = atomClusters->getInt(i);
+        }
+        for(size_t i = 0; i < analyzedStructureTypes.size(); i++){
+            structureTypes[inputIndex(order, i)] = analyzedStructureTypes[i];
         }
 
         // Build grain center-of-mass map
@@ -220,8 +482,19 @@ json GrainSegmentationService::performGrainSegmentation(
         json result;
         result["main_listing"] = {
             { "total_grains", static_cast<int>(engine2.grainCount()) },
-            { "merging_threshold", engine1->suggestedMergingThreshold() }
+            { "merging_threshold", engine1->suggestedMergingThreshold() },
+            { "coherent_interface_pass", interfacePassName(engine1->interfacePass()) },
+            { "orientation_precision", orientationPrecisionName(_orientationPrecision) },
+            { "disorientation_mode", disorientationModeName(_disorientationMode) },
+            { "clustering", clusteringModeName(_clusteringMode) },
+            { "kernel_isa", kernelIsaName(kernelIsa()) }
         };
+        if(_interfaceCache){
+            result["main_listing"]["interface_cache"] = {
+                { "hits", interfaceCacheHits },
+                { "misses", interfaceCacheMisses }
+            };
+        }
         result["sub_listings"] = { { "grains", grainsArray } };
 
         const std::string msgpackPath = outputFile + "_grains.msgpack";
@@ -18,6 +18,13 @@ void showUsage(const std::string& name) {
         << "  --adoptOrphanAtoms <true|false>       Adopt orphan atoms. [default: true]\n"
         << "  --handleCoherentInterfaces <true|false> Handle coherent interfaces. [default: true]\n"
         << "  --outputBonds                         Output neighbor bonds. [default: false]\n"
+        << "  --spatialReordering                   Sort atoms along a space-filling curve before analysis. [default: false]\n"
+        << "  --neighborBackend <ptm|tree|celllist> Neighbor search for the segmentation engine. [default: ptm]\n"
+        << "  --interfacePropagation <serial|parallel> Order of the coherent-interface pass. [default: serial]\n"
+        << "  --interfaceCache                      Cache interface disorientations per bond. [default: false]\n"
+        << "  --orientationPrecision <double|single> Storage precision of the orientations. [default: double]\n"
+        << "  --disorientationMode <exact|approximate> Lookup-table disorientations with exact fallback. [default: exact]\n"
+        << "  --clustering <chain|rac>              Merge sequence: nearest-neighbor chain or parallel rounds. [default: chain]\n"
         << "  --threads <int>                       Max worker threads (TBB/OMP). [default: auto]\n";
     printHelpOption();
 }
@@ -95,12 +102,63 @@ int main(int argc, char* argv[]) {
     int minGrainAtomCount = getInt(opts, "--minGrainAtomCount", 100);
     bool handleCoherentInterfaces = getString(opts, "--handleCoherentInterfaces", "true") == "true";
     bool outputBonds = hasOption(opts, "--outputBonds");
+    bool spatialReordering = hasOption(opts, "--spatialReordering");
+    std::string neighborBackendName = getString(opts, "--neighborBackend", "ptm");
+    NeighborSearchBackend neighborBackend = NeighborSearchBackend::PTM;
+    if (neighborBackendName == "tree") {
+        neighborBackend = NeighborSearchBackend::Tree;
+    } else if (neighborBackendName == "celllist") {
+        neighborBackend = NeighborSearchBackend::CellList;
+    } else if (neighborBackendName != "ptm") {
+        spdlog::error("Unknown neighbor backend: {}", neighborBackendName);
+        return 1;
+    }
+    std::string interfacePropagationName = getString(opts, "--interfacePropagation", "serial");
+    InterfacePropagation interfacePropagation = InterfacePropagation::Serial;
+    if (interfacePropagationName == "parallel") {
+        interfacePropagation = InterfacePropagation::Parallel;
+    } else if (interfacePropagationName != "serial") {
+        spdlog::error("Unknown interface propagation: {}", interfacePropagationName);
+        return 1;
+    }
+    bool interfaceCache = hasOption(opts, "--interfaceCache");
+    std::string precisionName = getString(opts, "--orientationPrecision", "double");
+    OrientationPrecision orientationPrecision = OrientationPrecision::Double;
+    if (precisionName == "single") {
+        orientationPrecision = OrientationPrecision::Single;
+    } else if (precisionName != "double") {
+        spdlog::error("Unknown orientation precision: {}", precisionName);
+        return 1;
+    }
+    std::string modeName = getString(opts, "--disorientationMode", "exact");
+    DisorientationMode disorientationMode = DisorientationMode::Exact;
+    if (modeName == "approximate") {
+        disorientationMode = DisorientationMode::Approximate;
+    } else if (modeName != "exact") {
+        spdlog::error("Unknown disorientation mode: {}", modeName);
+        return 1;
+    }
+    std::string clusteringName = getString(opts, "--clustering", "chain");
+    ClusteringMode clusteringMode = ClusteringMode::Chain;
+    if (clusteringName == "rac") {
+        clusteringMode = ClusteringMode::Reciprocal;
+    } else if (clusteringName != "chain") {
+        spdlog::error("Unknown clustering mode: {}", clusteringName);
+        return 1;
+    }
     
     spdlog::info("Grain segmentation parameters:");
     spdlog::info("  - adoptOrphanAtoms: {}", adoptOrphanAtoms);
     spdlog::info("  - minGrainAtomCount: {}", minGrainAtomCount);
     spdlog::info("  - handleCoherentInterfaces: {}", handleCoherentInterfaces);
     spdlog::info("  - outputBonds: {}", outputBonds);
+    spdlog::info("  - spatialReordering: {}", spatialReordering);
+    spdlog::info("  - neighborBackend: {}", neighborBackendName);
+    spdlog::info("  - interfacePropagation: {}", interfacePropagationName);
+    spdlog::info("  - interfaceCache: {}", interfaceCache);
+    spdlog::info("  - orientationPrecision: {}", precisionName);
+    spdlog::info("  - disorientationMode: {}", modeName);
+    spdlog::info("  - clustering: {}", clusteringName);
     
     GrainSegmentationService analyzer;
     analyzer.setRMSD(getDouble(opts, "--rmsd", 0.1f));
@@ -110,6 +168,13 @@ int main(int argc, char* argv[]) {
         handleCoherentInterfaces,
         outputBonds
     );
+    analyzer.setSpatialReordering(spatialReordering);
+    analyzer.setNeighborBackend(neighborBackend);
+    analyzer.setInterfacePropagation(interfacePropagation);
+    analyzer.setInterfaceCache(interfaceCache);
+    analyzer.setOrientationPrecision(orientationPrecision);
+    analyzer.setDisorientationMode(disorientationMode);
+    analyzer.setClusteringMode(clusteringMode);
     
     spdlog::info("Starting grain segmentation...");
     json result = analyzer.compute(frame, outputBase);
@@ -0,0 +1,80 @@
+// Segments the same synthetic polycrystal with exact and with approximate disorientations.
+// The approximate mode must keep the same merge candidates, each within the engine's
+// 0.05 degree tolerance of its exact disorientation, and may only move the atoms whose
+// merge order that difference decides.
+#include "synthetic_polycrystal.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <map>
+
+using namespace Volt;
+using namespace Volt::Testing;
+
+using Engine = GrainSegmentationEngine1<uint32_t, double>;
+
+namespace{
+
+constexpr double ToleranceDeg = 0.05;
+constexpr double MaxMismatchedFraction = 0.005;
+
+const EngineSetup<double> approximate = [](Engine& engine){
+    engine.setDisorientationMode(DisorientationMode::Approximate);
+};
+
+std::map<std::pair<uint32_t, uint32_t>, float> bondDisorientations(const Engine& engine){
+    const auto& bonds = engine.neighborBonds();
+    std::map<std::pair<uint32_t, uint32_t>, float> result;
+    for(size_t i = 0; i < bonds.size(); i++){
+        result[{ std::min(bonds.a[i], bonds.b[i]), std::max(bonds.a[i], bonds.b[i]) }] = bonds.disorientation[i];
+    }
+    return result;
+}
+
+}
+
+int main(){
+    int failures = 0;
+    for(const int hcpPlaneSpacing : { 0, 4 }){
+        const SyntheticPolycrystal crystal = makeSyntheticPolycrystal(24, 8, 11, hcpPlaneSpacing);
+        const auto orientations = crystal.orientationProperty(DataType::Double);
+
+        // Coherent interfaces are left alone here, so the HCP planes keep hexagonal bonds
+        // instead of being rotated into the FCC phase.
+        Engine exactEngine(crystal.positions, crystal.structures, orientations, crystal.correspondences, &crystal.cell, false, false);
+        exactEngine.perform();
+        Engine approximateEngine(crystal.positions, crystal.structures, orientations, crystal.correspondences, &crystal.cell, false, false);
+        approximate(approximateEngine);
+        approximateEngine.perform();
+
+        const auto exact = bondDisorientations(exactEngine);
+        const auto approximated = bondDisorientations(approximateEngine);
+        size_t missing = 0;
+        double maxError = 0.0;
+        for(const auto& [bond, disorientation] : approximated){
+            const auto it = exact.find(bond);
+            if(it == exact.end()){
+                missing++;
+                continue;
+            }
+            maxError = std::max(maxError, (double) std::abs(disorientation - it->second));
+        }
+        const bool sameBonds = missing == 0 && exact.size() == approximated.size();
+        const bool bondsFailed = !sameBonds || maxError > ToleranceDeg || approximateEngine.approximatedBonds() == 0;
+        std::printf("HCP plane spacing %d: %s  %zu merge candidates (%s), %zu approximated / %zu exact fallbacks, max error %.4f deg (bound %.2f)\n",
+            hcpPlaneSpacing, bondsFailed ? "FAILED" : "ok", approximated.size(), sameBonds ? "same set" : "sets differ",
+            approximateEngine.approximatedBonds(), approximateEngine.exactFallbacks(), maxError, ToleranceDeg);
+
+        const GrainAssignment exactGrains = segmentSyntheticPolycrystal<double>(crystal, DataType::Double);
+        const GrainAssignment approximateGrains = segmentSyntheticPolycrystal<double>(crystal, DataType::Double, approximate);
+        const size_t mismatched = mismatchedAtoms(exactGrains, approximateGrains);
+        const double fraction = (double) mismatched / crystal.size();
+        const bool grainsFailed = exactGrains.grainCount != approximateGrains.grainCount || fraction > MaxMismatchedFraction;
+        std::printf("HCP plane spacing %d: %s  grains exact %zu / approximate %zu, mismatched atoms %zu of %zu\n",
+            hcpPlaneSpacing, grainsFailed ? "FAILED" : "ok", exactGrains.grainCount, approximateGrains.grainCount, mismatched, crystal.size());
+
+        failures += bondsFailed + grainsFailed;
+    }
+    return failures ? 1 : 0;
+}
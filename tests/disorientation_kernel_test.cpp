@@ -0,0 +1,93 @@
+// Checks the batched disorientation kernel against PTM::calculateDisorientation for every
+// structure type. Types the engine routes through the kernel must agree; for the types
+// it leaves to PTM the agreement is only reported.
+#include <volt/grain_segmentation_engine.h>
+#include "test_orientations.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace Volt;
+using namespace Volt::Testing;
+
+using Engine = GrainSegmentationEngine1<uint32_t, double>;
+
+namespace{
+
+constexpr size_t PairsPerCase = 20000;
+constexpr double ToleranceDeg = 1e-3;
+
+// Pairs of three kinds: unrelated orientations, small misorientations, and small
+// misorientations on top of a symmetry rotation (90 degrees about x for cubic, 60 degrees
+// about c for hexagonal), which only the operator search brings back to a small angle.
+void makePairs(CrystalSymmetry symmetry, std::mt19937& rng, std::vector<Quat>& a, std::vector<Quat>& b){
+    std::uniform_real_distribution<double> small(0.0, 20.0);
+    const Quat symmetryRotation = symmetry == CrystalSymmetry::Cubic ? axisAngle(1, 0, 0, 90) : axisAngle(0, 0, 1, 60);
+
+    a.resize(PairsPerCase);
+    b.resize(PairsPerCase);
+    for(size_t i = 0; i < PairsPerCase; i++){
+        a[i] = randomOrientation(rng);
+        const Quat delta = randomRotation(rng, small(rng));
+        switch(i % 3){
+            case 0: b[i] = randomOrientation(rng); break;
+            case 1: b[i] = normalized(multiply(a[i], delta)); break;
+            default: b[i] = normalized(multiply(multiply(a[i], symmetryRotation), delta)); break;
+        }
+    }
+}
+
+// Largest difference in degrees between the kernel and PTM over the pairs.
+double maxKernelError(StructureType type, CrystalSymmetry symmetry, const std::vector<Quat>& a, const std::vector<Quat>& b){
+    const std::vector<float> out = kernelDisorientations(symmetry, a, b);
+    double maxError = 0.0;
+    for(size_t i = 0; i < a.size(); i++){
+        maxError = std::max(maxError, std::abs(ptmDisorientation(type, a[i], b[i]) - (double) out[i]));
+    }
+    return maxError;
+}
+
+struct Case{
+    const char* name;
+    StructureType type;
+    CrystalSymmetry nearestSymmetry;
+};
+
+}
+
+int main(){
+    const Case cases[] = {
+        { "SC", StructureType::SC, CrystalSymmetry::Cubic },
+        { "FCC", StructureType::FCC, CrystalSymmetry::Cubic },
+        { "BCC", StructureType::BCC, CrystalSymmetry::Cubic },
+        { "HCP", StructureType::HCP, CrystalSymmetry::Hexagonal },
+        { "CUBIC_DIAMOND", StructureType::CUBIC_DIAMOND, CrystalSymmetry::Cubic },
+        { "HEX_DIAMOND", StructureType::HEX_DIAMOND, CrystalSymmetry::Hexagonal },
+        { "GRAPHENE", StructureType::GRAPHENE, CrystalSymmetry::Hexagonal }
+    };
+
+    std::mt19937 rng(2024);
+    int failures = 0;
+    for(const Case& c : cases){
+        CrystalSymmetry symmetry = c.nearestSymmetry;
+        const bool kernel = Engine::crystalSymmetry(c.type, symmetry);
+
+        std::vector<Quat> a;
+        std::vector<Quat> b;
+        makePairs(symmetry, rng, a, b);
+        const double error = maxKernelError(c.type, symmetry, a, b);
+
+        if(!kernel){
+            std::printf("%-14s PTM path   kernel max error %.3g deg (not used)\n", c.name, error);
+        }else if(error > ToleranceDeg){
+            std::printf("%-14s FAILED     kernel max error %.3g deg\n", c.name, error);
+            failures++;
+        }else{
+            std::printf("%-14s kernel     max error %.3g deg\n", c.name, error);
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,116 @@
+// Checks that reducing orientations into the fundamental zone leaves the kernel's
+// disorientations unchanged: reduced, unreduced and PTM results must agree, in particular
+// for pairs whose misorientation sits at the kernel's identity early-exit bound and for
+// orientations at the boundary of the fundamental zone, where the reduction can pick
+// different symmetric copies for the two atoms.
+#include <volt/grain_segmentation_engine.h>
+#include "test_orientations.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace Volt;
+using namespace Volt::Testing;
+
+namespace{
+
+constexpr size_t PairsPerCase = 20000;
+constexpr double ToleranceDeg = 1e-3;
+
+struct Case{
+    const char* name;
+    StructureType type;
+    CrystalSymmetry symmetry;
+    double identityBoundDeg;            // Misorientation at which the kernel stops skipping the search.
+    std::vector<Quat> zoneBoundary;     // Orientations on the boundary of the fundamental zone.
+};
+
+// Offsets within a hundredth of a degree of an angle, on both sides of it.
+double nearAngle(std::mt19937& rng, double degrees){
+    std::uniform_real_distribution<double> offset(-0.01, 0.01);
+    return degrees + offset(rng);
+}
+
+void makePairs(const Case& c, std::mt19937& rng, std::vector<Quat>& a, std::vector<Quat>& b){
+    std::uniform_real_distribution<double> small(0.0, 5.0);
+    std::uniform_int_distribution<size_t> boundary(0, c.zoneBoundary.size() - 1);
+
+    a.resize(PairsPerCase);
+    b.resize(PairsPerCase);
+    for(size_t i = 0; i < PairsPerCase; i++){
+        switch(i % 4){
+            case 0:
+                // Misorientation right at the identity bound.
+                a[i] = randomOrientation(rng);
+                b[i] = normalized(multiply(a[i], randomRotation(rng, nearAngle(rng, c.identityBoundDeg))));
+                break;
+            case 1:
+                // Both atoms next to the same zone boundary orientation, so either may
+                // reduce to a different symmetric copy than its neighbor.
+                a[i] = normalized(multiply(c.zoneBoundary[boundary(rng)], randomRotation(rng, 0.01)));
+                b[i] = normalized(multiply(a[i], randomRotation(rng, small(rng))));
+                break;
+            case 2:
+                // Zone boundary orientation combined with a misorientation at the bound.
+                a[i] = normalized(multiply(c.zoneBoundary[boundary(rng)], randomRotation(rng, 0.01)));
+                b[i] = normalized(multiply(a[i], randomRotation(rng, nearAngle(rng, c.identityBoundDeg))));
+                break;
+            default:
+                a[i] = randomOrientation(rng);
+                b[i] = randomOrientation(rng);
+                break;
+        }
+    }
+}
+
+std::vector<Quat> reduced(CrystalSymmetry symmetry, std::vector<Quat> orientations){
+    for(Quat& q : orientations) reduceToFundamentalZone(symmetry, q.data());
+    return orientations;
+}
+
+}
+
+int main(){
+    const std::vector<Quat> cubicBoundary = {
+        axisAngle(1, 0, 0, 45), axisAngle(0, 1, 0, 45), axisAngle(0, 0, 1, -45),
+        axisAngle(1, 1, 1, 60), axisAngle(1, -1, 1, 60), axisAngle(1, 1, 0, 62.8)
+    };
+    const std::vector<Quat> hexagonalBoundary = {
+        axisAngle(0, 0, 1, 30), axisAngle(0, 0, 1, -30),
+        axisAngle(1, 0, 0, 90), axisAngle(0, 1, 0, 90), axisAngle(1, 1, 0, 90)
+    };
+    const Case cases[] = {
+        { "SC", StructureType::SC, CrystalSymmetry::Cubic, 45.0, cubicBoundary },
+        { "FCC", StructureType::FCC, CrystalSymmetry::Cubic, 45.0, cubicBoundary },
+        { "BCC", StructureType::BCC, CrystalSymmetry::Cubic, 45.0, cubicBoundary },
+        { "HCP", StructureType::HCP, CrystalSymmetry::Hexagonal, 30.0, hexagonalBoundary }
+    };
+
+    std::mt19937 rng(7);
+    int failures = 0;
+    for(const Case& c : cases){
+        std::vector<Quat> a;
+        std::vector<Quat> b;
+        makePairs(c, rng, a, b);
+
+        const std::vector<float> unreducedAngles = kernelDisorientations(c.symmetry, a, b);
+        const std::vector<float> reducedAngles = kernelDisorientations(c.symmetry, reduced(c.symmetry, a), reduced(c.symmetry, b));
+
+        double reducedError = 0.0;
+        double unreducedError = 0.0;
+        for(size_t i = 0; i < a.size(); i++){
+            const double reference = ptmDisorientation(c.type, a[i], b[i]);
+            reducedError = std::max(reducedError, std::abs(reference - (double) reducedAngles[i]));
+            unreducedError = std::max(unreducedError, std::abs(reference - (double) unreducedAngles[i]));
+        }
+
+        const bool failed = reducedError > ToleranceDeg || unreducedError > ToleranceDeg;
+        std::printf("%-4s %s  max error vs PTM: reduced %.3g deg, unreduced %.3g deg\n",
+            c.name, failed ? "FAILED" : "ok    ", reducedError, unreducedError);
+        if(failed) failures++;
+    }
+    return failures ? 1 : 0;
+}
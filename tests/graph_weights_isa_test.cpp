@@ -0,0 +1,98 @@
+// Runs computeGraphWeights with every instruction set the CPU supports and compares each
+// with the scalar variant, and the scalar variant with std::exp. The vector variants
+// promise bit-identical weights, which FMA contraction or a reordered polynomial would
+// break by an ulp or so.
+#include <volt/cpu_kernels.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace Volt;
+
+namespace{
+
+// Every variant must match scalar exactly.
+constexpr uint64_t MaxUlpsFromScalar = 0;
+
+// The degree 12 polynomial is accurate to about one ulp; allow a few for the rounding of
+// the argument reduction.
+constexpr double MaxRelativeErrorFromExp = 4 * 2.220446049250313e-16;
+
+uint64_t ulpDistance(double x, double y){
+    const int64_t a = std::bit_cast<int64_t>(x);
+    const int64_t b = std::bit_cast<int64_t>(y);
+    if((a < 0) != (b < 0)) return x == y ? 0 : UINT64_MAX;
+    return a > b ? (uint64_t) (a - b) : (uint64_t) (b - a);
+}
+
+// Angles in degrees: a fine sweep over the range of disorientations, the zero-angle
+// cutoff and its neighbors, the point where the exponent is clamped, and random values.
+std::vector<float> makeAngles(){
+    std::vector<float> angles;
+    for(int i = 0; i <= 200000; i++){
+        angles.push_back(100.0f * i / 200000);
+    }
+    for(const float edge : { 0.0f, -0.0f, 1e-5f, 45.8257f, 62.8f, 93.8f, 180.0f }){
+        angles.push_back(edge);
+        angles.push_back(std::nextafter(edge, -1.0f));
+        angles.push_back(std::nextafter(edge, 1000.0f));
+    }
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> any(0.0f, 180.0f);
+    std::uniform_real_distribution<float> small(0.0f, 1e-3f);
+    for(int i = 0; i < 50000; i++){
+        angles.push_back(i % 2 ? any(rng) : small(rng));
+    }
+    return angles;
+}
+
+}
+
+int main(){
+    const std::vector<float> angles = makeAngles();
+    const size_t n = angles.size();
+
+    std::vector<double> scalar(n);
+    computeGraphWeights(KernelIsa::Scalar, angles.data(), n, scalar.data());
+
+    double maxRelativeError = 0.0;
+    for(size_t i = 0; i < n; i++){
+        const double theta = (double) angles[i] < 1e-5 ? 0.0 : (double) angles[i];
+        // Same argument as the kernel, so only the exponential itself is compared.
+        const double expected = std::exp(std::max(-(1.0 / 3.0) * theta * theta, -700.0));
+        maxRelativeError = std::max(maxRelativeError, std::abs(scalar[i] - expected) / expected);
+    }
+    int failures = maxRelativeError > MaxRelativeErrorFromExp;
+    std::printf("%s  scalar vs std::exp: max relative error %.3g (bound %.3g)\n",
+        failures ? "FAILED" : "ok", maxRelativeError, MaxRelativeErrorFromExp);
+
+    for(const KernelIsa isa : { KernelIsa::Avx2, KernelIsa::Avx512 }){
+        if(!kernelIsaSupported(isa)){
+            std::printf("skip  %s: not supported by this CPU\n", kernelIsaName(isa));
+            continue;
+        }
+
+        // Unaligned starts and every tail length up to the widest vector.
+        uint64_t maxUlps = 0;
+        for(size_t offset = 0; offset < 3; offset++){
+            for(size_t tail = 0; tail < 9; tail++){
+                const size_t count = n - offset - tail;
+                std::vector<double> out(count);
+                computeGraphWeights(isa, angles.data() + offset, count, out.data());
+                for(size_t i = 0; i < count; i++){
+                    maxUlps = std::max(maxUlps, ulpDistance(out[i], scalar[offset + i]));
+                }
+            }
+        }
+        const bool failed = maxUlps > MaxUlpsFromScalar;
+        failures += failed;
+        std::printf("%s  %s vs scalar: max %llu ulp (bound %llu) over %zu weights\n",
+            failed ? "FAILED" : "ok", kernelIsaName(isa), (unsigned long long) maxUlps, (unsigned long long) MaxUlpsFromScalar, n);
+    }
+    return failures ? 1 : 0;
+}
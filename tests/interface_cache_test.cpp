@@ -0,0 +1,42 @@
+// Runs the coherent-interface pass with and without the per-bond interface cache, in both
+// propagation orders, and checks that the cache is hit and leaves the merge sequence
+// unchanged.
+#include "synthetic_polycrystal.h"
+
+#include <cstdio>
+
+using namespace Volt;
+using namespace Volt::Testing;
+
+using Engine = GrainSegmentationEngine1<uint32_t, double>;
+
+int main(){
+    const SyntheticPolycrystal crystal = makeSyntheticPolycrystal(20, 6, 5, 4);
+    const auto orientations = crystal.orientationProperty(DataType::Double);
+
+    int failures = 0;
+    for(InterfacePropagation propagation : { InterfacePropagation::Serial, InterfacePropagation::Parallel }){
+        Engine plain(crystal.positions, crystal.structures, orientations, crystal.correspondences, &crystal.cell, true, false);
+        plain.setInterfacePropagation(propagation);
+        plain.perform();
+
+        Engine cached(crystal.positions, crystal.structures, orientations, crystal.correspondences, &crystal.cell, true, false);
+        cached.setInterfacePropagation(propagation);
+        cached.setInterfaceCache(true);
+        cached.perform();
+
+        const auto& x = plain.dendrogram();
+        const auto& y = cached.dendrogram();
+        const bool same = x.size() == y.size() && std::equal(x.begin(), x.end(), y.begin(), [](const auto& p, const auto& q){
+            return p.a == q.a && p.b == q.b && p.distance == q.distance;
+        });
+        const bool performed = cached.interfacePass() == InterfacePass::Performed;
+        const bool failed = !same || !performed || cached.interfaceCacheHits() == 0 || plain.interfaceCacheMisses() != 0;
+        failures += failed;
+        std::printf("%s  %s: %zu hits / %zu misses, interface pass %s, dendrogram %s\n",
+            failed ? "FAILED" : "ok", propagation == InterfacePropagation::Serial ? "serial" : "parallel",
+            cached.interfaceCacheHits(), cached.interfaceCacheMisses(),
+            interfacePassName(cached.interfacePass()), same ? "identical" : "differs");
+    }
+    return failures ? 1 : 0;
+}
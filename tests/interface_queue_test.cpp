@@ -0,0 +1,105 @@
+// Drives GrainSegmentationEngine1::InterfaceQueue the way the serial interface pass does,
+// pushing only keys at or above the last popped one, and checks that it pops the same
+// entries as a single binary heap on (disorientation, a, b). Ties, keys at and above the
+// bound and rejected keys are covered.
+#include <volt/grain_segmentation_engine.h>
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+using namespace Volt;
+
+using Queue = GrainSegmentationEngine1<uint32_t, double>::InterfaceQueue;
+using Entry = Queue::Entry;
+
+namespace{
+
+constexpr double MaxKey = 4.0;
+
+struct Later{
+    bool operator()(const Entry& x, const Entry& y) const{
+        return std::tie(x.disorientation, x.a, x.b) > std::tie(y.disorientation, y.a, y.b);
+    }
+};
+
+bool same(const Entry& x, const Entry& y){
+    return x.disorientation == y.disorientation && x.a == y.a && x.b == y.b;
+}
+
+template<typename Function>
+bool throws(Function function){
+    try{
+        function();
+    }catch(const std::runtime_error&){
+        return true;
+    }
+    return false;
+}
+
+}
+
+int main(){
+    std::mt19937 rng(3);
+    // Few distinct keys, so many entries tie on the disorientation.
+    std::uniform_int_distribution<int> step(0, 40);
+    std::uniform_int_distribution<uint32_t> atom(0, 50);
+    std::uniform_int_distribution<int> children(0, 3);
+
+    Queue queue(MaxKey);
+    std::priority_queue<Entry, std::vector<Entry>, Later> reference;
+    size_t pushed = 0;
+    auto push = [&](double key){
+        const Entry entry{ key, atom(rng), atom(rng) };
+        queue.push(entry);
+        reference.push(entry);
+        pushed++;
+    };
+    for(int i = 0; i < 2000; i++){
+        push(step(rng) * 0.1);
+    }
+    push(MaxKey);
+    push(std::numeric_limits<double>::infinity());
+
+    int failures = 0;
+    size_t popped = 0;
+    while(!queue.empty() && !reference.empty()){
+        const Entry entry = queue.pop();
+        const Entry expected = reference.top();
+        reference.pop();
+        popped++;
+        if(!same(entry, expected)){
+            std::printf("FAILED  pop %zu: (%g, %u, %u) instead of (%g, %u, %u)\n", popped,
+                entry.disorientation, entry.a, entry.b, expected.disorientation, expected.a, expected.b);
+            failures++;
+        }
+
+        // New keys never lie below the popped one, but may land in the cursor bucket.
+        if(pushed < 6000 && std::isfinite(entry.disorientation)){
+            for(int c = children(rng); c > 0; c--){
+                push(std::min(MaxKey, entry.disorientation + step(rng) * 0.01));
+            }
+        }
+    }
+    if(!queue.empty() || !reference.empty()){
+        std::printf("FAILED  %zu of %zu entries popped\n", popped, pushed);
+        failures++;
+    }
+
+    if(!throws([&]{ queue.pop(); })){
+        std::printf("FAILED  pop from an empty queue did not throw\n");
+        failures++;
+    }
+    if(!throws([&]{ queue.push({ std::numeric_limits<double>::quiet_NaN(), 0, 1 }); })){
+        std::printf("FAILED  NaN key was accepted\n");
+        failures++;
+    }
+
+    std::printf("%s  %zu entries popped in (disorientation, a, b) order\n", failures ? "FAILED" : "ok", popped);
+    return failures ? 1 : 0;
+}
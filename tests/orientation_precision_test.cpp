@@ -0,0 +1,34 @@
+// Segments the same synthetic polycrystal with double and with single-precision
+// orientations, each fed from an orientation property of the matching type, and bounds
+// the difference in the grain assignment.
+#include "synthetic_polycrystal.h"
+
+#include <cstdio>
+
+using namespace Volt;
+using namespace Volt::Testing;
+
+namespace{
+
+// Float orientations carry about 1e-5 degrees of rounding, far below the PTM noise, so
+// only bonds whose merge order is decided by that rounding may move atoms.
+constexpr double MaxMismatchedFraction = 0.005;
+
+}
+
+int main(){
+    int failures = 0;
+    for(const int hcpPlaneSpacing : { 0, 4 }){
+        const SyntheticPolycrystal crystal = makeSyntheticPolycrystal(24, 8, 11, hcpPlaneSpacing);
+        const GrainAssignment doubles = segmentSyntheticPolycrystal<double>(crystal, DataType::Double);
+        const GrainAssignment floats = segmentSyntheticPolycrystal<float>(crystal, DataType::Float);
+
+        const size_t mismatched = mismatchedAtoms(doubles, floats);
+        const double fraction = (double) mismatched / crystal.size();
+        const bool failed = doubles.grainCount != floats.grainCount || fraction > MaxMismatchedFraction;
+        std::printf("HCP plane spacing %d: %s  grains double %zu / float %zu, mismatched atoms %zu of %zu\n",
+            hcpPlaneSpacing, failed ? "FAILED" : "ok", doubles.grainCount, floats.grainCount, mismatched, crystal.size());
+        if(failed) failures++;
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,64 @@
+// Hands Engine1 a neighbor table in which some rows are too short for the atom's type, as
+// PTM leaves them for atoms it could not match, and checks that only those rows are
+// searched again and that the merge sequence matches a full neighbor search.
+#include "synthetic_polycrystal.h"
+
+#include <cstdio>
+
+using namespace Volt;
+using namespace Volt::Testing;
+
+using Engine = GrainSegmentationEngine1<uint32_t, double>;
+
+namespace{
+
+// Every row sorted by distance, shortened to 3 neighbors for OTHER atoms and every 50th
+// crystalline atom.
+Engine::NeighborTable shortenedNeighborTable(const SyntheticPolycrystal& crystal, size_t& shortened){
+    PTM finder;
+    finder.prepare(crystal.positions->constDataPoint3(), crystal.size(), crystal.cell);
+    NearestNeighborFinder::Query<PTM::MAX_INPUT_NEIGHBORS> query(finder);
+
+    Engine::NeighborTable table;
+    table.offsets.push_back(0);
+    shortened = 0;
+    for(size_t i = 0; i < crystal.size(); i++){
+        query.findNeighbors(i);
+        int count = std::min((int) query.results().size(), PTM::MAX_INPUT_NEIGHBORS);
+        if(crystal.structures->getInt(i) == (int) StructureType::OTHER || i % 50 == 0){
+            count = std::min(count, 3);
+            shortened++;
+        }
+        for(int j = 0; j < count; j++){
+            table.indices.push_back((uint32_t) query.results()[j].index);
+            table.distancesSq.push_back(query.results()[j].distanceSq);
+        }
+        table.offsets.push_back(table.indices.size());
+    }
+    return table;
+}
+
+}
+
+int main(){
+    const SyntheticPolycrystal crystal = makeSyntheticPolycrystal(20, 6, 5, 4);
+    const auto orientations = crystal.orientationProperty(DataType::Double);
+
+    Engine searched(crystal.positions, crystal.structures, orientations, crystal.correspondences, &crystal.cell, true, false);
+    searched.perform();
+
+    size_t shortened = 0;
+    Engine completed(crystal.positions, crystal.structures, orientations, crystal.correspondences, &crystal.cell,
+        shortenedNeighborTable(crystal, shortened), true, false);
+    completed.perform();
+
+    const auto& x = searched.dendrogram();
+    const auto& y = completed.dendrogram();
+    const bool same = x.size() == y.size() && std::equal(x.begin(), x.end(), y.begin(), [](const auto& p, const auto& q){
+        return p.a == q.a && p.b == q.b && p.distance == q.distance;
+    });
+    const bool failed = !same || completed.searchedNeighborRows() != shortened;
+    std::printf("%s  %zu of %zu rows shortened, %zu searched again, dendrogram %s\n",
+        failed ? "FAILED" : "ok", shortened, crystal.size(), completed.searchedNeighborRows(), same ? "identical" : "differs");
+    return failed ? 1 : 0;
+}
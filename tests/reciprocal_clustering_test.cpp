@@ -0,0 +1,37 @@
+// Segments the same synthetic polycrystal with the nearest-neighbor chain and with
+// round-based reciprocal clustering and bounds the difference in the grain assignment.
+#include "synthetic_polycrystal.h"
+
+#include <cstdio>
+
+using namespace Volt;
+using namespace Volt::Testing;
+
+namespace{
+
+// Both modes merge the same reciprocal nearest neighbors, so only bonds whose merge order
+// is decided by ties or rounding of the distances may move atoms.
+constexpr double MaxMismatchedFraction = 0.005;
+
+}
+
+int main(){
+    const EngineSetup<double> reciprocalMode = [](GrainSegmentationEngine1<uint32_t, double>& engine){
+        engine.setClusteringMode(ClusteringMode::Reciprocal);
+    };
+
+    int failures = 0;
+    for(const int hcpPlaneSpacing : { 0, 4 }){
+        const SyntheticPolycrystal crystal = makeSyntheticPolycrystal(24, 8, 11, hcpPlaneSpacing);
+        const GrainAssignment chain = segmentSyntheticPolycrystal<double>(crystal, DataType::Double);
+        const GrainAssignment reciprocal = segmentSyntheticPolycrystal<double>(crystal, DataType::Double, reciprocalMode);
+
+        const size_t mismatched = mismatchedAtoms(chain, reciprocal);
+        const double fraction = (double) mismatched / crystal.size();
+        const bool failed = chain.grainCount != reciprocal.grainCount || fraction > MaxMismatchedFraction;
+        std::printf("HCP plane spacing %d: %s  grains chain %zu / reciprocal %zu, mismatched atoms %zu of %zu\n",
+            hcpPlaneSpacing, failed ? "FAILED" : "ok", chain.grainCount, reciprocal.grainCount, mismatched, crystal.size());
+        if(failed) failures++;
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+// Synthetic polycrystal for the end-to-end tests and benchmarks: a periodic cube of atoms
+// on a jittered grid, split into Voronoi grains of random orientation. Atoms close to a
+// grain boundary are disordered, and optional HCP planes give the coherent-interface
+// pass work to do.
+#include <volt/grain_segmentation_engine.h>
+#include "test_orientations.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace Volt::Testing{
+
+struct SyntheticPolycrystal{
+    SimulationCell cell;
+    std::shared_ptr<ParticleProperty> positions;
+    std::shared_ptr<ParticleProperty> structures;
+    std::shared_ptr<ParticleProperty> correspondences;
+    std::vector<Quat> orientations;
+
+    size_t size() const{
+        return orientations.size();
+    }
+
+    // Orientations as a four-component Float or Double property.
+    std::shared_ptr<ParticleProperty> orientationProperty(DataType type) const{
+        auto property = std::make_shared<ParticleProperty>(size(), type, 4, 0, false);
+        for(size_t i = 0; i < size(); i++){
+            for(size_t c = 0; c < 4; c++){
+                if(type == DataType::Float){
+                    property->setFloatComponent(i, c, (float) orientations[i][c]);
+                }else{
+                    property->setDoubleComponent(i, c, orientations[i][c]);
+                }
+            }
+        }
+        return property;
+    }
+};
+
+// cellsPerSide^3 atoms in grainCount grains. Each atom's orientation is its grain's
+// orientation with a Gaussian perturbation of noiseDeg. With hcpPlaneSpacing > 0 every
+// hcpPlaneSpacing-th plane of crystalline atoms is HCP instead of FCC.
+inline SyntheticPolycrystal makeSyntheticPolycrystal(int cellsPerSide, int grainCount, unsigned seed, int hcpPlaneSpacing = 0, double noiseDeg = 0.7){
+    std::mt19937 rng(seed);
+    const double L = cellsPerSide;
+    const size_t n = (size_t) cellsPerSide * cellsPerSide * cellsPerSide;
+
+    SyntheticPolycrystal crystal;
+    crystal.cell.setMatrix(AffineTransformation(Vector3(L, 0, 0), Vector3(0, L, 0), Vector3(0, 0, L), Vector3(0, 0, 0)));
+    crystal.cell.setPbcFlags(true, true, true);
+    crystal.positions = std::make_shared<ParticleProperty>(n, ParticleProperty::PositionProperty, 0, true);
+    crystal.structures = std::make_shared<ParticleProperty>(n, DataType::Int, 1, 0, false);
+    crystal.correspondences = std::make_shared<ParticleProperty>(n, DataType::Int64, 1, 0, false);
+    crystal.orientations.resize(n);
+
+    std::uniform_real_distribution<double> uniform(0.0, L);
+    std::vector<Point3> seeds(grainCount);
+    std::vector<Quat> grainOrientations(grainCount);
+    for(int g = 0; g < grainCount; g++){
+        seeds[g] = Point3(uniform(rng), uniform(rng), uniform(rng));
+        grainOrientations[g] = randomOrientation(rng);
+    }
+
+    std::uniform_real_distribution<double> jitter(-0.05, 0.05);
+    std::normal_distribution<double> noise(0.0, noiseDeg);
+    size_t i = 0;
+    for(int z = 0; z < cellsPerSide; z++){
+        for(int y = 0; y < cellsPerSide; y++){
+            for(int x = 0; x < cellsPerSide; x++, i++){
+                const Point3 p(x + jitter(rng), y + jitter(rng), z + jitter(rng));
+                crystal.positions->setPoint3(i, p);
+
+                double nearest = 1e300;
+                double second = 1e300;
+                int grain = 0;
+                for(int g = 0; g < grainCount; g++){
+                    const Vector3 delta = crystal.cell.wrapVector(p - seeds[g]);
+                    const double d = std::sqrt(delta.squaredLength());
+                    if(d < nearest){
+                        second = nearest;
+                        nearest = d;
+                        grain = g;
+                    }else if(d < second){
+                        second = d;
+                    }
+                }
+
+                StructureType type = (second - nearest < 0.8) ? StructureType::OTHER : StructureType::FCC;
+                if(type == StructureType::FCC && hcpPlaneSpacing > 0 && z % hcpPlaneSpacing == hcpPlaneSpacing - 1){
+                    type = StructureType::HCP;
+                }
+                crystal.structures->setInt(i, (int) type);
+                crystal.correspondences->setInt64(i, 0);
+                crystal.orientations[i] = normalized(multiply(grainOrientations[grain], randomRotation(rng, std::abs(noise(rng)))));
+            }
+        }
+    }
+    return crystal;
+}
+
+// Grain id of every atom after both engines ran, 0 for atoms in no grain.
+struct GrainAssignment{
+    std::vector<int> grainIds;
+    size_t grainCount = 0;
+};
+
+template<typename Real>
+using EngineSetup = std::function<void(GrainSegmentationEngine1<uint32_t, Real>&)>;
+
+template<typename Real>
+GrainAssignment segmentSyntheticPolycrystal(const SyntheticPolycrystal& crystal, DataType orientationType, const EngineSetup<Real>& setup = {}){
+    auto engine1 = std::make_shared<GrainSegmentationEngine1<uint32_t, Real>>(
+        crystal.positions,
+        crystal.structures,
+        crystal.orientationProperty(orientationType),
+        crystal.correspondences,
+        &crystal.cell,
+        true,
+        false
+    );
+    if(setup) setup(*engine1);
+    engine1->perform();
+
+    GrainSegmentationEngine2<uint32_t, Real> engine2(engine1, true, 100, true);
+    engine2.perform();
+
+    GrainAssignment result;
+    result.grainCount = engine2.grainCount();
+    result.grainIds.resize(crystal.size());
+    for(size_t i = 0; i < crystal.size(); i++){
+        result.grainIds[i] = engine2.atomClusters()->getInt(i);
+    }
+    return result;
+}
+
+// Atoms outside the largest overlap of their grain in x with a grain of y.
+inline size_t unmatchedAtoms(const GrainAssignment& x, const GrainAssignment& y){
+    std::map<std::pair<int, int>, size_t> overlap;
+    for(size_t i = 0; i < x.grainIds.size(); i++){
+        overlap[{ x.grainIds[i], y.grainIds[i] }]++;
+    }
+    std::map<int, size_t> best;
+    for(const auto& [grains, count] : overlap){
+        best[grains.first] = std::max(best[grains.first], count);
+    }
+    size_t matched = 0;
+    for(const auto& [grain, count] : best){
+        matched += count;
+    }
+    return x.grainIds.size() - matched;
+}
+
+// Atoms whose grain differs between the two assignments, matching grains by largest
+// overlap in both directions so that split and merged grains both count. Zero when the
+// assignments differ only by the numbering of the grains.
+inline size_t mismatchedAtoms(const GrainAssignment& x, const GrainAssignment& y){
+    return std::max(unmatchedAtoms(x, y), unmatchedAtoms(y, x));
+}
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+// Orientation helpers shared by the disorientation tests.
+#include <volt/disorientation_kernel.h>
+#include <volt/analysis/ptm.h>
+
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace Volt::Testing{
+
+// Unit quaternions as (x, y, z, w), the component order of Quaternion's constructor.
+using Quat = std::array<double, 4>;
+
+inline Quat normalized(Quat q){
+    const double n = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    for(double& c : q) c /= n;
+    return q;
+}
+
+inline Quat multiply(const Quat& p, const Quat& q){
+    return {
+        p[3] * q[0] + p[0] * q[3] + p[1] * q[2] - p[2] * q[1],
+        p[3] * q[1] - p[0] * q[2] + p[1] * q[3] + p[2] * q[0],
+        p[3] * q[2] + p[0] * q[1] - p[1] * q[0] + p[2] * q[3],
+        p[3] * q[3] - p[0] * q[0] - p[1] * q[1] - p[2] * q[2]
+    };
+}
+
+inline Quat axisAngle(double x, double y, double z, double degrees){
+    const double half = 0.5 * degrees * M_PI / 180.0;
+    const double s = std::sin(half) / std::sqrt(x * x + y * y + z * z);
+    return { x * s, y * s, z * s, std::cos(half) };
+}
+
+inline Quat randomOrientation(std::mt19937& rng){
+    std::normal_distribution<double> normal;
+    return normalized({ normal(rng), normal(rng), normal(rng), normal(rng) });
+}
+
+// Rotation by the given angle about a uniformly random axis.
+inline Quat randomRotation(std::mt19937& rng, double degrees){
+    std::normal_distribution<double> normal;
+    return axisAngle(normal(rng), normal(rng), normal(rng), degrees);
+}
+
+// PTM::calculateDisorientation for a same-type pair.
+inline double ptmDisorientation(StructureType type, const Quat& a, const Quat& b){
+    return PTM::calculateDisorientation(type, type, Quaternion(a[0], a[1], a[2], a[3]), Quaternion(b[0], b[1], b[2], b[3]));
+}
+
+// computeDisorientations over pairs (a[i], b[i]).
+inline std::vector<float> kernelDisorientations(CrystalSymmetry symmetry, const std::vector<Quat>& a, const std::vector<Quat>& b){
+    const size_t n = a.size();
+    std::vector<double> columns[8];
+    for(auto& column : columns) column.resize(n);
+    for(size_t i = 0; i < n; i++){
+        for(int k = 0; k < 4; k++){
+            columns[k][i] = a[i][k];
+            columns[4 + k][i] = b[i][k];
+        }
+    }
+
+    std::vector<float> out(n);
+    const QuaternionBatch qa{ columns[0].data(), columns[1].data(), columns[2].data(), columns[3].data() };
+    const QuaternionBatch qb{ columns[4].data(), columns[5].data(), columns[6].data(), columns[7].data() };
+    if(symmetry == CrystalSymmetry::Cubic){
+        computeDisorientations<CrystalSymmetry::Cubic>(qa, qb, n, out.data());
+    }else{
+        computeDisorientations<CrystalSymmetry::Hexagonal>(qa, qb, n, out.data());
+    }
+    return out;
+}
+
+}